@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "types.hpp"
+
+class GradMesh;
+
+// The edges a merge can be attempted at, one entry per twin pair, in a dense array with a slot index per half-edge. The
+// first half of a pair is the one on the lower face, so a rebuild lists them in the order a face-order scan meets them.
+// update() only rechecks the edges the mesh changed since the last update, entries that are still valid keep their slot.
+class CandidateMerges
+{
+public:
+    // Full scan in face order
+    void rebuild(GradMesh &mesh);
+    void update(GradMesh &mesh);
+    // Patch ids shift whenever a face before them is removed, so updates leave the curve ids stale until this is called
+    void resolveCurveIds(const GradMesh &mesh);
+
+    // Entry that holds the half-edge as either half, or -1
+    int find(int halfEdgeIdx) const;
+    // Random entry not picked since the last resetPicks, or -1 if every entry was. Picking moves entries around.
+    int pickUntried(std::mt19937 &gen);
+    void resetPicks() { numUntried = merges.size(); }
+
+    size_t size() const { return merges.size(); }
+    bool empty() const { return merges.empty(); }
+    DoubleHalfEdge &operator[](size_t i) { return merges[i]; }
+    const DoubleHalfEdge &operator[](size_t i) const { return merges[i]; }
+    auto begin() { return merges.begin(); }
+    auto end() { return merges.end(); }
+    auto begin() const { return merges.begin(); }
+    auto end() const { return merges.end(); }
+    const std::vector<DoubleHalfEdge> &entries() const { return merges; }
+
+private:
+    // The half that holds the entry of a valid merge edge, -1 if the edge is not one
+    static int ownerOf(const GradMesh &mesh, int halfEdgeIdx);
+    static bool onFaceLoop(const GradMesh &mesh, int halfEdgeIdx);
+    static CurveId curveOf(const GradMesh &mesh, const std::vector<int> &patchIdxs, int halfEdgeIdx);
+    void insert(int halfEdgeIdx, int twinIdx);
+    void erase(size_t slot);
+    void swapSlots(size_t a, size_t b);
+    void setSlot(size_t slot);
+
+    std::vector<DoubleHalfEdge> merges; // the untried entries first, see pickUntried
+    std::vector<int> firstSlot;         // per half-edge, the entry it is halfEdgeIdx1 of
+    std::vector<int> secondSlot;        // per half-edge, the entry it is halfEdgeIdx2 of
+    size_t numUntried = 0;
+    bool curveIdsStale = false;
+    std::vector<int> recheck; // scratch for update
+};
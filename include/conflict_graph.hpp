@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gradmesh.hpp"
+
+// Conflict graph of the TPRs in CSR form, the neighbours of node i are neighbours[offsets[i]] up to
+// neighbours[offsets[i + 1]], in increasing order. The arrays are immutable and shared between copies, they are either
+// owned by the graph or live in a mapped .tprb file.
+class ConflictGraph
+{
+public:
+    ConflictGraph() = default;
+    explicit ConflictGraph(const std::vector<std::vector<int>> &neighbourLists);
+    // Views arrays that storage keeps alive
+    ConflictGraph(std::span<const uint32_t> offsets, std::span<const int> neighbours, std::shared_ptr<const void> storage);
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::span<const int> operator[](size_t node) const { return neighbours.subspan(offsets[node], offsets[node + 1] - offsets[node]); }
+    std::span<const uint32_t> getOffsets() const { return offsets; }
+    std::span<const int> getNeighbours() const { return neighbours; }
+
+private:
+    std::shared_ptr<const void> storage;
+    std::span<const uint32_t> offsets;
+    std::span<const int> neighbours;
+};
+
+// Binary counterpart of the text conflict graph file: the header, the TPR node table, the CSR offsets and neighbours of
+// the conflict graph, then the edge regions with their region attributes in a second CSR table. Everything is
+// little-endian and 4-byte aligned, the graph is used straight from the mapped file.
+inline constexpr std::string_view TPRB_EXTENSION{".tprb"};
+inline constexpr char TPRB_MAGIC[8] = {'T', 'P', 'R', 'G', 'R', 'A', 'P', 'H'};
+inline constexpr uint32_t TPRB_VERSION{1};
+
+namespace tprb
+{
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t numNodes;
+        uint32_t numNeighbours; // both directions of every conflict
+        uint32_t numRegions;
+        uint32_t numAttributes;
+        uint32_t reserved;
+    };
+
+    struct NodeRecord
+    {
+        int32_t id;
+        int32_t gridPair[2];
+        int32_t maxRegion[2];
+        float error;
+        int32_t maxChainLength;
+        int32_t degree;
+    };
+
+    struct RegionRecord
+    {
+        int32_t gridPair[2];
+        int32_t faceIdx;
+        uint32_t firstAttribute; // into the attribute table
+        uint32_t numAttributes;
+    };
+
+    struct AttributeRecord
+    {
+        int32_t maxRegion[2];
+        float error;
+        int32_t maxChainLength;
+        float aabb[4]; // min x, min y, max x, max y
+    };
+
+    static_assert(sizeof(Header) == 32);
+    static_assert(sizeof(NodeRecord) == 32);
+    static_assert(sizeof(RegionRecord) == 20);
+    static_assert(sizeof(AttributeRecord) == 32);
+    static_assert(sizeof(int) == sizeof(int32_t));
+}
+
+bool isConflictGraphBinaryFile(const std::string &filename);
+// Throws on a malformed file and leaves the outputs unchanged then
+void readConflictGraphBinaryFile(const std::string &filename, std::vector<TPRNode> &allTPRs, ConflictGraph &adjList, std::vector<EdgeRegion> &sortedRegions);
+void writeConflictGraphBinaryFile(const std::string &filename, const std::vector<TPRNode> &allTPRs, const ConflictGraph &adjList, const std::vector<EdgeRegion> &sortedRegions);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-size set of indices in [0, size), one bit per index
+class DenseBitset
+{
+public:
+    DenseBitset() = default;
+    explicit DenseBitset(size_t size) : words((size + 63) / 64, 0) {}
+
+    bool test(size_t idx) const { return (words[idx / 64] >> (idx % 64)) & 1; }
+    void set(size_t idx) { words[idx / 64] |= uint64_t{1} << (idx % 64); }
+    void reset(size_t idx) { words[idx / 64] &= ~(uint64_t{1} << (idx % 64)); }
+    void clear() { std::fill(words.begin(), words.end(), 0); }
+    // all indices are cleared
+    void resize(size_t size) { words.assign((size + 63) / 64, 0); }
+
+private:
+    std::vector<uint64_t> words;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Indices of the elements changed since the last reset, each listed once. Only elements that existed at the last reset
+// are tracked, the ones appended since are always considered changed.
+struct DirtyList
+{
+    std::vector<char> flags; // one per element that existed at the last reset
+    std::vector<int> idxs;
+
+    void mark(int idx)
+    {
+        if (idx >= 0 && static_cast<size_t>(idx) < flags.size() && !flags[idx])
+        {
+            flags[idx] = 1;
+            idxs.push_back(idx);
+        }
+    }
+    void reset(size_t numElements)
+    {
+        for (int idx : idxs)
+            if (static_cast<size_t>(idx) < flags.size())
+                flags[idx] = 0;
+        idxs.clear();
+        flags.resize(numElements, 0);
+    }
+};
@@ -1,18 +1,22 @@
 #pragma once
 
 #include <cctype>
+#include <charconv>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <glm/glm.hpp>
 
+#include "conflict_graph.hpp"
 #include "gradmesh.hpp"
 #include "gms_appstate.hpp"
+#include "hemesh_binary.hpp"
 #include "patch.hpp"
 #include "types.hpp"
 
@@ -20,8 +24,12 @@ class GradMesh;
 
 std::vector<std::string> splitString(const std::string &str);
 GradMesh readHemeshFile(const std::string &filename);
+GradMesh readHemeshFileStream(const std::string &filename);
 // GradMesh readCgmFile(const std::string &filename);
 void writeHemeshFile(const std::string &filename, const GradMesh &mesh);
+// Pick the text or binary format from the extension
+GradMesh readMeshFile(const std::string &filename);
+void writeMeshFile(const std::string &filename, const GradMesh &mesh);
 void writeLogFile(const GradMesh &mesh, const std::string &filename);
 
 // Function to save the current framebuffer to a PNG file
@@ -33,5 +41,7 @@ void setupDirectories();
 bool isValidNumber(const std::string &str);
 int safeStringToInt(const std::string &str);
 
-void saveConflictGraphToFile(const std::string &filename, const std::vector<TPRNode> &allTPRs, const std::vector<std::vector<int>> &adjList, const std::vector<EdgeRegion> &sortedRegions);
-void loadConflictGraphFromFile(const std::string &filename, std::vector<TPRNode> &allTPRs, std::vector<std::vector<int>> &adjList, std::vector<EdgeRegion> &sortedRegions);
\ No newline at end of file
+// Pick the text or binary format from the extension
+void saveConflictGraphToFile(const std::string &filename, const std::vector<TPRNode> &allTPRs, const ConflictGraph &adjList, const std::vector<EdgeRegion> &sortedRegions);
+// False if the file could not be read, the outputs are left unchanged then
+bool loadConflictGraphFromFile(const std::string &filename, std::vector<TPRNode> &allTPRs, ConflictGraph &adjList, std::vector<EdgeRegion> &sortedRegions);
\ No newline at end of file
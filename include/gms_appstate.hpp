@@ -3,12 +3,14 @@
 #include <string>
 #include <vector>
 
+#include "candidate_merges.hpp"
 #include "curve_renderer.hpp"
 #include "fileio.hpp"
 #include "gradmesh.hpp"
 #include "merge_metrics.hpp"
 #include "merge_select.hpp"
 #include "patch.hpp"
+#include "patch_index.hpp"
 #include "patch_renderer.hpp"
 #include "types.hpp"
 
@@ -75,6 +77,7 @@ enum class MergeProcess
     RandomTest,
     GridTest,
     DualGridTest,
+    CompareRenderBackends,
     Merging
 };
 
@@ -104,9 +107,7 @@ public:
 
     GmsAppState()
     {
-        // make sure to gen textures after intializing opengl
-        glGenTextures(1, &patchRenderResources.unmergedTexture);
-        glGenTextures(1, &patchRenderResources.mergedTexture);
+        // no GL calls here, gms-cli uses the app state without a context
         updateCurveRender();
     }
 
@@ -125,6 +126,10 @@ public:
     int regionsMerged = 0;
     ConflictGraphStats conflictGraphStats;
     float quadErrorWeight = 0.75;
+    // Local search after each greedy TPR selection, off while both are 0. The iterations are repeatable, the time in
+    // milliseconds depends on the machine.
+    int independentSetIterations = 0;
+    float independentSetTime = 0.0f;
     std::string loadPreprocessingFilename;
     float oneStepQuadErrorProgress{-1.0f};
 
@@ -132,12 +137,17 @@ public:
     std::string filename = "../meshes/avocado.hemesh";
     std::string meshname;
     bool filenameChanged = false;
-    bool loadSave = false;
+    bool undoRequested = false;
+    bool redoRequested = false;
+    bool cancelRequested = false; // stops the running preprocessing
 
     // Mesh and mesh rendering data
     GradMesh mesh;
+    GradMesh originalMesh; // in-memory copy of save_0, what the preprocessing and greedy strategies start from
     std::vector<GLfloat> originalGlPatches;
     std::vector<Patch> patches;
+    PatchIndex patchIndex; // picking grid over patches, rebuilt with them
+    PatchLookup patchLookup; // face -> patch and half-edge -> curve, rebuilt with them
     PatchRenderer::PatchRenderParams patchRenderParams;
     CurveRenderer::CurveRenderParams curveRenderParams{CurveRenderer::Hermite, {}};
 
@@ -158,7 +168,7 @@ public:
     CurveId userSelectedId{-1, -1};
 
     // Merging edge selection
-    std::vector<DoubleHalfEdge> candidateMerges{};
+    CandidateMerges candidateMerges;
     int selectedEdgeId = -1;
     int numOfMerges = 0;
     int attemptedMergesIdx = 0;
@@ -166,6 +176,7 @@ public:
     // Single merge stats
     MergeStats mergeStats;
     int currentSave = 0;
+    bool writeMeshSaves = true; // write save_N.hemesh after each accepted merge, plus the debug mesh logs
 
     // Merging metrics - capturing pixels and error
     bool useError = true;
@@ -174,10 +185,12 @@ public:
     float mergePreviewError;
 
     MergeMetrics::PatchRenderResources patchRenderResources;
+    MergeMetrics::CapturedImages metricImages;
     std::vector<int> selectedProductRegionIdxs;
 
     void setSelectedDhe(CurveId selectedCurve)
     {
+        candidateMerges.resolveCurveIds(mesh);
         for (size_t i = 0; i < candidateMerges.size(); i++)
         {
             auto &dhe = candidateMerges[i];
@@ -193,6 +206,7 @@ public:
     }
     void resetSelectedDhe()
     {
+        candidateMerges.resolveCurveIds(mesh);
         auto &dhe = candidateMerges[selectedEdgeId];
         selectedEdgeId = -1;
         setPatchCurveColor(dhe.curveId1, black);
@@ -201,6 +215,8 @@ public:
     void updateMeshRender(const std::vector<Patch> &patchData = {}, const std::vector<GLfloat> &glPatchData = {})
     {
         patches = patchData.empty() ? mesh.generatePatches().value() : patchData;
+        patchIndex.build(patches);
+        patchLookup.build(patches);
         patchRenderParams.glPatches = glPatchData.empty() ? getAllPatchGLData(patches, &Patch::getControlMatrix) : glPatchData;
         patchRenderParams.glCurves = getAllPatchGLData(patches, &Patch::getCurveData);
         patchRenderParams.handles = mesh.getHandleBars();
@@ -221,12 +237,12 @@ public:
     {
         numOfMerges = 0;
         regionsMerged = 0;
-        loadSave = false;
+        undoRequested = redoRequested = cancelRequested = false;
         filenameChanged = false;
         mergeStatus = NA;
         selectedEdgeId = -1;
         meshname = extractFileName(filename);
-        loadPreprocessingFilename = std::string{TPR_PREPROCESSING_DIR} + "/" + meshname + ".txt";
+        loadPreprocessingFilename = std::string{TPR_PREPROCESSING_DIR} + "/" + meshname + std::string{TPRB_EXTENSION};
     }
     void setPatchCurveColor(CurveId someCurve, glm::vec3 col)
     {
@@ -239,6 +255,7 @@ public:
     }
     void showAllCandidateEdges(glm::vec3 col)
     {
+        candidateMerges.resolveCurveIds(mesh);
         for (auto &dhe : candidateMerges)
         {
             auto &c1 = dhe.curveId1;
@@ -253,13 +270,13 @@ public:
         auto edgeIdxs = mesh.getRegionBorderIdxs(gridPair, maxRegion);
         for (int idx : selectedProductRegionIdxs)
         {
-            auto curve = getCurveIdFromEdgeIdx(patches, idx);
+            auto curve = patchLookup.curveOfEdge(idx);
             patches[curve.patchId].setCurveSelected(curve.curveId, black);
         }
         selectedProductRegionIdxs.clear();
         for (int edgeIdx : edgeIdxs)
         {
-            auto curve = getCurveIdFromEdgeIdx(patches, edgeIdx);
+            auto curve = patchLookup.curveOfEdge(edgeIdx);
             patches[curve.patchId].setCurveSelected(curve.curveId, green);
             selectedProductRegionIdxs.push_back(edgeIdx);
         }
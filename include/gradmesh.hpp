@@ -1,17 +1,22 @@
 #pragma once
 
 #include <cassert>
+#include <initializer_list>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <memory>
 #include <optional>
 #include <ranges>
+#include <span>
 #include <vector>
 
 #include "gms_math.hpp"
+#include "dirty_list.hpp"
+#include "mesh_journal.hpp"
 #include "ostream_ops.hpp"
 #include "patch.hpp"
+#include "patch_cache.hpp"
 #include "types.hpp"
 
 class GradMeshMerger;
@@ -93,28 +98,112 @@ public:
     }
     void addHandle(float x, float y, float r, float g, float b, int idx)
     {
+        patchCache.markHandle(handles.size());
         handles.push_back(Handle{glm::vec2(x, y), glm::vec3(r, g, b), idx});
     }
     void addFace(int idx)
     {
+        patchCache.markFace(faces.size());
         faces.push_back(Face{idx});
     }
-    int addEdge(HalfEdge edge)
+    // The edge gets the given child list, which must not point into this mesh
+    int addEdge(HalfEdge edge, std::span<const int> children = {})
     {
+        edge.children = {static_cast<int>(childArena.size()), static_cast<int>(children.size())};
+        childArena.insert(childArena.end(), children.begin(), children.end());
+        patchCache.markEdge(edges.size());
         edges.push_back(edge);
         return edges.size() - 1;
     }
+    void reserve(size_t numPoints, size_t numHandles, size_t numFaces, size_t numEdges)
+    {
+        points.reserve(numPoints);
+        handles.reserve(numHandles);
+        faces.reserve(numFaces);
+        edges.reserve(numEdges);
+    }
+    void reserveChildren(size_t numChildren) { childArena.reserve(numChildren); }
+    // Exact comparison of the mesh elements, used to verify file round trips
+    bool sameAs(const GradMesh &other) const;
+
+    // In-memory undo journal, mutations must go through the edit* accessors to be recorded. Transactions nest: commit()
+    // folds the innermost one into its parent, rollback(n) reverts the n innermost ones in O(edited elements).
+    // A committed outermost transaction is either dropped or kept in the undo history for undo()/redo().
+    void beginTransaction();
+    void commit(bool keepForUndo = false);
+    void rollback(int n = 1);
+    int transactionDepth() const { return journal.openIds.size(); }
+    bool undo();
+    bool redo();
+    bool canUndo() const { return !journal.edges.history.empty() && journal.openIds.empty(); }
+    bool canRedo() const { return !journal.edges.redoStack.empty() && journal.openIds.empty(); }
+    void clearJournal();
+    // The edit* accessors also mark the element for the patch cache. Points are not marked, merges only change which
+    // half-edge a point belongs to and never move it.
+    HalfEdge &editEdge(int idx)
+    {
+        patchCache.markEdge(idx);
+        changedEdges.mark(idx);
+        return journal.edges.edit(edges, idx, journal.currentId());
+    }
+    Handle &editHandle(int idx)
+    {
+        patchCache.markHandle(idx);
+        return journal.handles.edit(handles, idx, journal.currentId());
+    }
+    Point &editPoint(int idx) { return journal.points.edit(points, idx, journal.currentId()); }
+    Face &editFace(int idx)
+    {
+        patchCache.markFace(idx);
+        return journal.faces.edit(faces, idx, journal.currentId());
+    }
+
     const auto &getEdges() const { return edges; }
+    // Child lists of parent half-edges. The span is invalidated by the next child list edit. The setters write a new
+    // slice and go through editEdge, so they are journaled like any other edge change.
+    std::span<const int> getChildren(const HalfEdge &edge) const
+    {
+        return {childArena.data() + edge.children.first, static_cast<size_t>(edge.children.count)};
+    }
+    std::span<const int> getChildren(int edgeIdx) const { return getChildren(edges[edgeIdx]); }
+    void setChildren(int edgeIdx, std::span<const int> children);
+    void setChildren(int edgeIdx, std::initializer_list<int> children) { setChildren(edgeIdx, std::span<const int>{children.begin(), children.size()}); }
+    void addChildren(int edgeIdx, std::span<const int> newChildren); // skips children already in the list
+    void addChildren(int edgeIdx, std::initializer_list<int> newChildren) { addChildren(edgeIdx, std::span<const int>{newChildren.begin(), newChildren.size()}); }
+    void replaceChild(int edgeIdx, int oldChildIdx, int newChildIdx);
+    void removeChild(int edgeIdx, int childIdx);
     const auto &getFaces() const { return faces; }
     const auto &getHandles() const { return handles; }
     const auto &getPoints() const { return points; }
     AABB getMeshAABB() const;
 
+    // Patches of all valid faces, or nullopt if one cannot be built. Only the faces touched since the last call are
+    // regenerated, see PatchCache.
     std::optional<std::vector<Patch>> generatePatches() const;
+    std::optional<Patch> generatePatch(int faceIdx) const;
+    // Updates the patch cache without copying the patches out, false if a valid face has no patch
+    bool updatePatchCache() const { return patchCache.update(*this); }
+    const PatchCache &getPatchCache() const { return patchCache; }
+    // Calls f for every edge edited, appended, or restored by a rollback, undo or redo since the last call, then starts
+    // over. An index past the edge count belongs to an edge a rollback dropped.
+    template <typename F>
+    void takeChangedEdges(F f)
+    {
+        for (int idx : changedEdges.idxs)
+            f(idx);
+        for (size_t idx = changedEdges.flags.size(); idx < edges.size(); idx++)
+            f(static_cast<int>(idx));
+        changedEdges.reset(edges.size());
+    }
     std::vector<Vertex> getHandleBars() const;
     std::vector<Vertex> getControlPoints() const;
     void fixEdges();
-    bool isULMergeEdge(const HalfEdge &edge) const;
+    // Marks the boundary points with more than two edges, merges at their edges are the UL merges
+    void findULPoints();
+    bool isULMergeEdge(const HalfEdge &edge) const
+    {
+        return isULPoint(edge.originIdx) || (edge.hasTwin() && isULPoint(edges[edge.twinIdx].originIdx));
+    }
 
     // Returns the twin edge of the given edge
     int getTwinIdx(int halfEdgeIdx) const { return edges[halfEdgeIdx].twinIdx; }
@@ -141,6 +230,7 @@ public:
 
     friend std::ostream &operator<<(std::ostream &out, const GradMesh &gradMesh);
     friend class GradMeshMerger;
+    friend class PatchMerger;
     friend class MergeMetrics;
     friend class MergeSelect;
     friend class MergePreprocessor;
@@ -153,7 +243,7 @@ private:
     void disablePoint(const HalfEdge &e)
     {
         if (e.originIdx != -1)
-            points[e.originIdx].disable();
+            editPoint(e.originIdx).disable();
     }
     bool edgeIs(int edgeIdx, const auto &edgeFn) const
     {
@@ -181,6 +271,8 @@ private:
         int idx = e.twinIdx;
         if (e.isBar())
             idx = edges[e.parentIdx].twinIdx; // once again i'm bad
+        if (idx == -1)
+            return false;
 
         const auto &twin = edges[idx];
         if (twin.isBar())
@@ -192,14 +284,24 @@ private:
     AABB getAffectedMergeAABB(int halfEdgeIdx) const;
     AABB getFaceAABB(int halfEdgeIdx) const;
 
-    void findULPoints();
+    // Marks what a rollback, undo or redo is about to restore (or just reapplied) for the patch cache
+    void markTouched(const ElementJournal<HalfEdge>::Mark &edgeMark, const ElementJournal<Handle>::Mark &handleMark,
+                     const ElementJournal<Face>::Mark &faceMark);
+    bool isULPoint(int pointIdx) const
+    {
+        return pointIdx >= 0 && static_cast<size_t>(pointIdx) < ulPoints.size() && ulPoints[pointIdx];
+    }
     std::vector<int> getIncidentFacesOfRegion(const Region &region) const;
-    bool regionsOverlap(const Region &region1, const Region &region2) const;
 
     std::vector<Point> points;
     std::vector<Handle> handles;
     std::vector<Face> faces;
     std::vector<HalfEdge> edges;
+    std::vector<int> childArena; // the child lists of all edges, see ChildRange
+
+    std::vector<char> ulPoints; // per point, set by findULPoints for boundary points with more than two edges
 
-    std::vector<int> ulPointIdxs;
+    MeshJournal journal;
+    mutable PatchCache patchCache;
+    DirtyList changedEdges; // for the incremental consumers of the topology, see takeChangedEdges
 };
\ No newline at end of file
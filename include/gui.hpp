@@ -67,7 +67,7 @@ void showComponentSelect(GmsAppState &appState);
 void showHermiteMatrixTable(GmsAppState &appState);
 void showPreviousMergeInfo(GmsAppState::MergeStats &stats);
 void showGradMeshInfo(GmsAppState &appState);
-void setHalfEdgeInfo(const auto &components, int &item_selected_idx, const auto &idxs);
+void setHalfEdgeInfo(const GradMesh &mesh, int &item_selected_idx, const auto &idxs);
 void setFaceInfo(const auto &components, int &item_selected_idx, const auto &idxs);
 void pushColor(ButtonColor color);
 
@@ -141,6 +141,7 @@ constexpr const char *toString(int cornerFlags)
 
 constexpr const char *renderModeStrings[] = {"Patch", "Curve"};
 constexpr const char *metric_mode_items[] = {"SSIM", "FLIP"};
+constexpr const char *render_backend_items[] = {"OpenGL", "CPU"};
 constexpr const char *edge_select_items[] = {"Manual", "Random", "Grid", "Dual Grid", "Motorcycle", "Greedy", "1-Step Greedy"};
 static int edge_select_current = 1;
 
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "gradmesh.hpp"
+
+// Binary counterpart of .hemesh. The file is the header followed by the point, handle, face and edge record arrays and
+// the child index array, all little-endian and 4-byte aligned, so it can be mapped and copied without any parsing.
+// It stores the mesh as it is in memory (after fixEdges), a loaded mesh is identical to the one that was written.
+inline constexpr std::string_view HEMESHB_EXTENSION{".hemeshb"};
+inline constexpr char HEMESHB_MAGIC[8] = {'H', 'E', 'M', 'E', 'S', 'H', 'B', '\0'};
+inline constexpr uint32_t HEMESHB_VERSION{1};
+
+namespace hemeshb
+{
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t numPoints;
+        uint32_t numHandles;
+        uint32_t numFaces;
+        uint32_t numEdges;
+        uint32_t numChildren;
+    };
+
+    struct PointRecord
+    {
+        float coords[2];
+        int32_t halfEdgeIdx;
+    };
+
+    struct HandleRecord
+    {
+        float coords[2];
+        float color[3];
+        int32_t halfEdgeIdx;
+    };
+
+    struct FaceRecord
+    {
+        int32_t halfEdgeIdx;
+    };
+
+    struct EdgeRecord
+    {
+        float interval[2];
+        float twistCoords[2];
+        float twistColor[3];
+        float color[3];
+        int32_t handleIdxs[2];
+        int32_t twinIdx;
+        int32_t prevIdx;
+        int32_t nextIdx;
+        int32_t faceIdx;
+        int32_t originIdx;
+        int32_t parentIdx;
+        int32_t childIdxDegenerate;
+        uint32_t firstChild; // into the child index array
+        uint32_t numChildren;
+    };
+
+    static_assert(sizeof(Header) == 32);
+    static_assert(sizeof(PointRecord) == 12);
+    static_assert(sizeof(HandleRecord) == 24);
+    static_assert(sizeof(FaceRecord) == 4);
+    static_assert(sizeof(EdgeRecord) == 84);
+}
+
+bool isHemeshBinaryFile(const std::string &filename);
+GradMesh readHemeshBinaryFile(const std::string &filename);
+void writeHemeshBinaryFile(const std::string &filename, const GradMesh &mesh);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Non-owning view of an interleaved 8-bit image. Rows are stored bottom-up, as read back from OpenGL
+struct ImageView
+{
+    const uint8_t *data = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+
+    bool empty() const { return data == nullptr || width == 0 || height == 0; }
+    bool sameShape(const ImageView &other) const
+    {
+        return width == other.width && height == other.height && channels == other.channels;
+    }
+    size_t size() const { return static_cast<size_t>(width) * height * channels; }
+};
+
+// Owning image buffer, reused between captures so repeated renders at the same resolution do not reallocate
+struct Image
+{
+    int width = 0;
+    int height = 0;
+    int channels = 3;
+    std::vector<uint8_t> pixels;
+
+    void resize(int w, int h, int c = 3)
+    {
+        width = w;
+        height = h;
+        channels = c;
+        pixels.resize(static_cast<size_t>(w) * h * c);
+    }
+    bool empty() const { return pixels.empty(); }
+    ImageView view() const { return {pixels.data(), width, height, channels}; }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "image.hpp"
+
+inline constexpr int SSIM_WINDOW_RADIUS{5}; // 11x11 Gaussian window with sigma 1.5, as in Wang et al.'s ssim_index.m
+inline constexpr float SSIM_WINDOW_SIGMA{1.5f};
+inline constexpr int SSIM_TILE_SIZE{32};
+
+// Gaussian-blurred means and variances of a reference image, computed once and shared read-only between threads.
+// SSIM is averaged over the channels and over the 'valid' window positions (the image minus the window radius on
+// every side), the map is split into tiles so callers can rescore parts of it. All channels of a tile are scored in one
+// pass over the interleaved pixels, with an AVX2 kernel where the CPU supports it. rmgr averages over a map that covers
+// every pixel instead and stays the default. With nativeSSIM on this defines every SSIM score, global and local, with or
+// without error maps (gms-cli --compare-metrics prints how far apart the two are).
+class SSIMReference
+{
+public:
+    explicit SSIMReference(const ImageView &reference);
+
+    bool matches(const ImageView &image) const;
+    bool sameShape(const ImageView &image) const;
+    int numTiles() const { return tilesX * tilesY; }
+    int mapWidth() const { return mapW; }
+    int mapHeight() const { return mapH; }
+    int channels() const { return numChannels; }
+
+    // Sum of the SSIM map over one tile and all channels, thread-safe
+    double tileSum(const ImageView &image, int tileIdx, float *ssimMap = nullptr) const;
+    // Mean SSIM of the whole image, summed from the tile sums in tile order like IncrementalSSIM. The map, if given,
+    // receives the SSIM of every window position, mapWidth x mapHeight with the channels interleaved.
+    float score(const ImageView &image, float *ssimMap = nullptr) const;
+    float meanFromTileSums(const std::vector<double> &tileSums) const;
+
+private:
+    friend class IncrementalSSIM;
+    struct TileRect
+    {
+        int mx0, mx1, my0, my1;
+    };
+    TileRect tileRect(int tileIdx) const;
+
+    int width = 0;
+    int height = 0;
+    int numChannels = 0;
+    int mapW = 0;
+    int mapH = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<uint8_t> pixels;
+    std::vector<float> mean;     // per window position and channel, interleaved like the image
+    std::vector<float> variance; // per window position and channel
+};
+
+// Mean SSIM of images against a shared reference. The tile sums of the last scored image are cached, the next image
+// only recomputes the tiles whose window reaches a pixel that differs from it. The mean is always summed from the tile
+// sums in the same order, so an incremental score is bit-identical to scoring the same image from scratch.
+class IncrementalSSIM
+{
+public:
+    void setReference(std::shared_ptr<const SSIMReference> newReference);
+    const std::shared_ptr<const SSIMReference> &getReference() const { return reference; }
+    float score(const ImageView &image);
+    // Drops the cached tiles, the next score recomputes the whole map
+    void invalidate() { base.clear(); }
+    int lastDirtyTiles() const { return numDirtyTiles; }
+
+private:
+    void markDirtyTiles(const ImageView &image);
+
+    std::shared_ptr<const SSIMReference> reference;
+    std::vector<uint8_t> base; // last scored image, the cached tile sums belong to it
+    std::vector<double> tileSums;
+    std::vector<char> tileDirty;
+    std::vector<int> dirtyTileIdxs;
+    int numDirtyTiles = 0;
+};
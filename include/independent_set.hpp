@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "conflict_graph.hpp"
+#include "dense_bitset.hpp"
+
+// Maximum weight independent set of a conflict graph whose summed cost stays below a capacity. The solver starts from a
+// given set, usually a greedy one, and improves it by iterated local search: (k,1)-swaps insert a vertex and drop its
+// neighbours in the set, (1,2)-swaps replace a set vertex by two of its neighbours, and a random forced insertion
+// perturbs the set between local searches. It can be stopped at any time, the best set found so far is kept.
+class IndependentSetSolver
+{
+public:
+    IndependentSetSolver(const ConflictGraph &graph, std::vector<float> weights, std::vector<float> costs, float capacity, unsigned seed = 0);
+
+    // The vertices have to be independent and fit the capacity, they become the best set
+    void setSolution(std::span<const int> vertices);
+    // Iterated local search until the budget or the number of iterations runs out, returns the iterations done
+    int improve(std::chrono::duration<double> budget, int maxIterations = std::numeric_limits<int>::max());
+
+    // Sorted vertices of the best set
+    std::vector<int> getBestSet() const;
+    double getBestWeight() const { return bestWeight; }
+
+private:
+    bool fits(double extraCost) const { return cost + extraCost < capacity; }
+    void setMember(int v, bool member);
+    void insert(int v);
+    void remove(int v);
+    void push(int v);
+    void undo(size_t journalSize);
+
+    bool trySwapIn(int v);
+    bool tryTwoForOne(int v);
+    void localSearch();
+    void perturb();
+
+    const ConflictGraph &graph;
+    std::vector<float> weights;
+    std::vector<float> costs;
+    double capacity;
+    std::mt19937 gen;
+
+    DenseBitset inSet;
+    std::vector<int> tightness;    // number of neighbours in the set
+    std::vector<int> solution;     // the set in no particular order
+    std::vector<int> solutionSlot; // position in solution, -1 outside the set
+    double weight = 0.0;
+    double cost = 0.0;
+
+    DenseBitset queued;
+    std::vector<int> worklist;               // vertices whose neighbourhood in the set changed
+    std::vector<std::pair<int, bool>> journal; // inserted (true) or removed vertices since the best set
+    std::vector<int> marks;                  // marks[v] == markStamp for the neighbours of the vertex being checked
+    int markStamp = 0;
+
+    std::vector<int> bestSolution;
+    double bestWeight = 0.0;
+};
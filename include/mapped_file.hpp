@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file, mapped where mmap is available
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &filename);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return bytes; }
+    size_t fileSize() const { return size; }
+
+private:
+    const char *bytes = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    std::vector<char> buffer;
+#endif
+};
+
+// Copies count records starting at offset, the mapping is only guaranteed to be page aligned at the start
+template <typename T>
+std::vector<T> readRecords(const MappedFile &file, size_t &offset, size_t count)
+{
+    std::vector<T> records(count);
+    size_t numBytes = count * sizeof(T);
+    if (offset + numBytes > file.fileSize())
+        throw std::runtime_error("Binary file is truncated\n");
+    if (numBytes > 0)
+        std::memcpy(records.data(), file.data() + offset, numBytes);
+    offset += numBytes;
+    return records;
+}
+
+// Views count records starting at offset without copying, the offset has to be a multiple of the record alignment
+template <typename T>
+std::span<const T> viewRecords(const MappedFile &file, size_t &offset, size_t count)
+{
+    size_t numBytes = count * sizeof(T);
+    if (offset + numBytes > file.fileSize())
+        throw std::runtime_error("Binary file is truncated\n");
+    if (offset % alignof(T) != 0)
+        throw std::runtime_error("Binary file has misaligned records\n");
+    std::span<const T> records{reinterpret_cast<const T *>(file.data() + offset), count};
+    offset += numBytes;
+    return records;
+}
+
+template <typename T>
+void writeRecords(std::ofstream &out, std::span<const T> records)
+{
+    out.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(T));
+}
+
+template <typename T>
+void writeRecords(std::ofstream &out, const std::vector<T> &records)
+{
+    writeRecords(out, std::span<const T>{records});
+}
@@ -1,10 +1,10 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
-#include <unordered_map>
 
 #include <rmgr/ssim.h>
 #include <rmgr/ssim-openmp.h>
@@ -16,7 +16,12 @@
 #include "stb_image_write.h"
 
 #include "gradmesh.hpp"
+#include "image.hpp"
+#include "incremental_ssim.hpp"
+#include "metric_context.hpp"
 #include "patch.hpp"
+#include "patch_rasterizer.hpp"
+#include "patch_vertex_buffer.hpp"
 #include "renderer.hpp"
 #include "types.hpp"
 
@@ -142,10 +147,17 @@ public:
         Global,
         Local
     };
+    enum RenderBackend
+    {
+        OpenGL,
+        CPU // software rasterizer, needs no GL context
+    };
     struct PatchRenderResources
     {
         GLuint unmergedTexture;
         GLuint mergedTexture;
+        GLuint originalPreviewTexture;
+        GLuint currentPreviewTexture;
         int patchShaderId;
         int curveShaderId;
     };
@@ -153,6 +165,7 @@ public:
     {
         MetricMode metricMode = MetricMode::SSIM;
         PixelRegion pixelRegion = PixelRegion::Global;
+        RenderBackend renderBackend = RenderBackend::OpenGL;
         AABB aabb{};
         std::pair<int, int> aabbRes;
         AABB globalAABB{};
@@ -163,52 +176,95 @@ public:
         float aabbPadding = AABB_PADDING;
         float singleMergeErrorThreshold{0.0001f};
         bool showMotorcycleEdges = true;
+        bool writeDebugImages = false; // also write every captured image and error map as PNG
+        bool nativeSSIM = false;       // every SSIM score goes through SSIMReference instead of rmgr, off because it averages
+                                       // over fewer windows than rmgr and the thresholds were tuned with rmgr
+    };
+    // Framebuffer captures kept in memory, the metrics read these instead of round-tripping through PNG files
+    struct CapturedImages
+    {
+        Image original; // unmerged mesh, the reference for global metrics
+        Image current;  // mesh after the last (attempted) merge
+        Image merged;   // scratch capture for a merge under evaluation
+        Image previous; // local AABB before the merge
     };
     struct Params
     {
         GradMesh &mesh;
         MergeSettings &mergeSettings;
         PatchRenderResources &patchRenderResources;
+        CapturedImages &images;
     };
 
     MergeMetrics(Params params);
     void setAABB();
-    void captureGlobalImage(const std::vector<GLfloat> &glPatches, const char *imgPath);
+    void captureGlobalImage(const std::vector<GLfloat> &glPatches, Image &image, const char *debugImgPath = nullptr);
     void captureBeforeMerge(const std::vector<GLfloat> &glPatches, AABB &aabb);
-    void captureAfterMerge(const std::vector<GLfloat> &glPatches, const char *imgPath);
-    float getMergeError(const std::vector<GLfloat> &glPatches, const char *imgPath);
+    void captureAfterMerge(const std::vector<GLfloat> &glPatches, Image &image, const char *debugImgPath = nullptr);
+    float getMergeError(const std::vector<GLfloat> &glPatches, Image &image, const char *debugImgPath = nullptr);
+    float getGlobalError(const std::vector<GLfloat> &glPatches);
+    // Software render at the global capture resolution, safe to call from several threads
+    void rasterizeGlobalImage(const std::vector<GLfloat> &glPatches, Image &image) const
+    {
+        rasterizePatches(glPatches, mergeSettings.globalPaddedAABB, mergeSettings.globalAABBRes.first, mergeSettings.globalAABBRes.second, image);
+    }
+    // Software captureBeforeMerge and getMergeError for a mesh copy, safe to call from several threads as long as each
+    // brings its own context, SSIM engine and images
+    void rasterizeBeforeMerge(const std::vector<GLfloat> &glPatches, AABB &aabb, Image &previous) const;
+    float rasterizeMergeError(MetricContext &context, IncrementalSSIM &ssim, const std::vector<GLfloat> &glPatches, const AABB &aabb, const Image &previous, Image &image) const;
+    // Variants that render the mesh through the persistent patch buffer, call updatePatchBuffer after editing the mesh
+    bool updatePatchBuffer() { return patchBuffer.update(mesh); }
+    void captureGlobalImage(Image &image, const char *debugImgPath = nullptr);
+    float getMergeError(Image &image, const char *debugImgPath = nullptr);
+    ImageDifference compareRenderBackends(const std::vector<GLfloat> &glPatches);
+    MetricDifference compareSSIMEngines(const std::vector<GLfloat> &glPatches);
 
     void setEdgeErrorMap(const std::vector<DoubleHalfEdge> &dhes);
     void generateEdgeErrorMap(EdgeErrorDisplay edgeErrorDisplay);
     void setBoundaryEdges(std::vector<SingleHalfEdge> &bes) { boundaryEdges = bes; }
-    float evaluateMetric(const char *compImgPath = MERGE_METRIC_IMG, const char *compImgPath2 = ORIG_IMG);
+    // Uses the metrics' own context and writes the error map when debug images are on, for the merging thread only
+    float evaluateMetric(const ImageView &compImg, const ImageView &refImg);
+    // Safe to call from several threads as long as each brings its own context
+    float evaluateMetric(MetricContext &context, const ImageView &compImg, const ImageView &refImg, const char *errorMapPath = nullptr) const;
+    float evaluateMetric(MetricContext &context, const ImageView &compImg, const char *errorMapPath = nullptr) const;
     void setValenceVertices();
     std::vector<MergeableRegion> getMergeableRegions();
     void findSumOfErrors(MergeableRegion &mr);
 
 private:
+    void renderPatches(const std::vector<GLfloat> &glPatches, const AABB &aabb, std::pair<int, int> res, bool mergedTarget, Image &image,
+                       PatchVertexBuffer *buffer = nullptr);
+    GLuint getFramebuffer(bool mergedTarget);
+    float evaluateGlobalMetric(const ImageView &compImg);
+    bool useNativeSSIM(const ImageView &refImg) const;
     void generateMotorcycleGraph();
     void markTwoHalfEdges(int idx1, int idx2);
     void unmarkTwoHalfEdges(int idx1, int idx2);
     bool isMarked(int halfEdgeIdx);
+    std::pair<int, int> valenceSlot(int halfEdgeIdx) const;
     void getMergeableRegion(std::vector<int> &alreadyVisited, std::vector<MergeableRegion> &mergeableRegions, int halfEdgeIdx);
 
-    GLuint unmergedFbo;
-    GLuint mergedFbo;
+    GLuint unmergedFbo = 0; // created on first use so the CPU backend never touches GL
+    GLuint mergedFbo = 0;
+    PatchVertexBuffer patchBuffer; // slots of the faces a merge touched are the only ones rewritten
+    std::shared_ptr<const SSIMReference> ssimReference; // statistics of images.original, rebuilt when it is captured
+    IncrementalSSIM globalSSIM;
+    MetricContext metricContext;
 
     GradMesh &mesh;
     PatchRenderResources &patchRenderResources;
     MergeSettings &mergeSettings;
+    CapturedImages &images;
 
     std::vector<Patch> edgeErrorPatches;
     std::vector<DoubleHalfEdge> edgeErrors;
+    std::vector<int> edgeErrorIdxs; // per half-edge, the first entry of edgeErrors holding it or -1
     glm::vec2 minMaxError;
     std::vector<SingleHalfEdge> boundaryEdges;
     std::vector<ValenceVertex> valenceVertices;
     std::vector<DoubleHalfEdge> motorcycleEdges;
     std::vector<float> halfEdgeErrors;
-
-    std::unordered_map<int, std::pair<int, int>> lookupValenceVertex;
+    std::vector<std::pair<int, int>> lookupValenceVertex; // per half-edge, its valence vertex and slot
 };
 
 struct FBtoImgParams
@@ -217,15 +273,16 @@ struct FBtoImgParams
     GLuint fbo;
     int width;
     int height;
-    const char *imgPath;
+    Image &image;
     const std::vector<GLfloat> &glPatches;
     int shaderId;
     const AABB &aabb;
+    PatchVertexBuffer *patchBuffer = nullptr; // drawn instead of glPatches when set
 };
 
-float evaluateSSIM(const char *img1Path, const char *img2Path);
-float evaluateFLIP(const char *img1Path, const char *img2Path);
 void drawPatches(const std::vector<GLfloat> &glPatches, int patchShaderId, const AABB &aabb);
+void readPixels(int width, int height, Image &image);
+bool writeImagePNG(const ImageView &image, const char *imgPath);
 void writeToImage(int resolution, const char *imgPath);
 void writeToImage(int width, int height, const char *imgPath);
 
@@ -234,4 +291,5 @@ void closeFBO();
 
 void FBtoImg(const FBtoImgParams &params);
 
-GLuint LoadTextureFromFile(const char *filename);
\ No newline at end of file
+GLuint LoadTextureFromFile(const char *filename);
+void uploadImageToTexture(const ImageView &image, GLuint texture);
\ No newline at end of file
@@ -13,7 +13,10 @@ class MergeSelect
 {
 public:
     MergeSelect(GmsAppState &state);
+    // Full scan, optionally collecting the edges that can never be merged
     void findCandidateMerges(std::vector<SingleHalfEdge> *boundaryEdges = nullptr);
+    // Rechecks only the edges the mesh changed since the last scan or update
+    void updateCandidateMerges();
     int selectEdge();
     void reset();
 
@@ -28,7 +31,6 @@ private:
     void detectOverlappingCorners();
 
     GmsAppState &state;
-    std::vector<int> selectedEdgePool; // for random selection
 
     std::pair<int, int> cornerEdges = {-1, -1}; // for grid selection
     std::pair<int, int> currAdjPair = {-1, -1};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "types.hpp"
+
+// Undo journal for one element array of a GradMesh. Inside a transaction, the first edit of an element stores its old
+// value; rolling back replays the stored values in reverse and drops the elements appended since the transaction began.
+template <typename T>
+struct ElementJournal
+{
+    struct Mark
+    {
+        size_t logSize;      // saved entries when the transaction began
+        size_t elementCount; // elements when the transaction began
+    };
+    struct Changes
+    {
+        std::vector<std::pair<int, T>> values; // values after the transaction, reapplied on redo
+        std::vector<T> added;                  // elements the transaction appended
+    };
+
+    std::vector<std::pair<int, T>> saved;
+    std::vector<unsigned> recordedBy; // transaction that last saved the element
+    std::vector<Mark> open;           // one per open transaction, innermost last
+    std::vector<Mark> history;        // committed transactions that can be undone
+    std::vector<Changes> redoStack;
+
+    void begin(const std::vector<T> &elements)
+    {
+        open.push_back({saved.size(), elements.size()});
+        if (recordedBy.size() < elements.size())
+            recordedBy.resize(elements.size(), 0);
+    }
+    T &edit(std::vector<T> &elements, int idx, unsigned transactionId)
+    {
+        // elements appended inside the transaction are dropped on rollback, so they are never saved
+        if (!open.empty() && static_cast<size_t>(idx) < open.back().elementCount && recordedBy[idx] != transactionId)
+        {
+            recordedBy[idx] = transactionId;
+            saved.emplace_back(idx, elements[idx]);
+        }
+        return elements[idx];
+    }
+    void commit(bool keepForUndo)
+    {
+        Mark mark = open.back();
+        open.pop_back();
+        if (!open.empty())
+            return; // the entries now belong to the enclosing transaction
+
+        redoStack.clear();
+        if (keepForUndo)
+            history.push_back(mark);
+        else
+            saved.erase(saved.begin() + mark.logSize, saved.end());
+    }
+    void rollback(std::vector<T> &elements)
+    {
+        revert(elements, open.back());
+        open.pop_back();
+    }
+    void undo(std::vector<T> &elements)
+    {
+        Mark mark = history.back();
+        history.pop_back();
+        Changes changes;
+        for (size_t i = mark.logSize; i < saved.size(); i++)
+        {
+            size_t idx = saved[i].first;
+            if (idx < mark.elementCount) // later elements are restored through added
+                changes.values.emplace_back(saved[i].first, elements[idx]);
+        }
+        changes.added.assign(elements.begin() + mark.elementCount, elements.end());
+        redoStack.push_back(std::move(changes));
+        revert(elements, mark);
+    }
+    void redo(std::vector<T> &elements, unsigned transactionId)
+    {
+        Changes changes = std::move(redoStack.back());
+        redoStack.pop_back();
+        begin(elements);
+        for (auto &[idx, value] : changes.values)
+            edit(elements, idx, transactionId) = std::move(value);
+        for (auto &element : changes.added)
+            elements.push_back(std::move(element));
+        history.push_back(open.back());
+        open.pop_back();
+    }
+    // Elements the transaction behind mark saved or appended, the ones rollback/undo/redo change without edit()
+    template <typename F>
+    void forEachTouched(const Mark &mark, size_t numElements, F f) const
+    {
+        for (size_t i = mark.logSize; i < saved.size(); i++)
+            f(saved[i].first);
+        for (size_t idx = mark.elementCount; idx < numElements; idx++)
+            f(static_cast<int>(idx));
+    }
+    void clear()
+    {
+        saved.clear();
+        open.clear();
+        history.clear();
+        redoStack.clear();
+    }
+
+private:
+    void revert(std::vector<T> &elements, const Mark &mark)
+    {
+        // reverse order so an element saved by several nested transactions ends at its oldest value
+        for (size_t i = saved.size(); i-- > mark.logSize;)
+            elements[saved[i].first] = std::move(saved[i].second);
+        saved.erase(saved.begin() + mark.logSize, saved.end());
+        elements.erase(elements.begin() + mark.elementCount, elements.end());
+    }
+};
+
+struct MeshJournal
+{
+    ElementJournal<Point> points;
+    ElementJournal<Handle> handles;
+    ElementJournal<Face> faces;
+    ElementJournal<HalfEdge> edges;
+    std::vector<size_t> childArenaSizes; // per open transaction, everything appended later is dropped on rollback
+
+    std::vector<unsigned> openIds;
+    unsigned nextId = 1;
+
+    unsigned currentId() const { return openIds.empty() ? 0 : openIds.back(); }
+    unsigned newId()
+    {
+        // ids are never reused, so a stale recordedBy stamp cannot match a later transaction
+        return nextId++;
+    }
+};
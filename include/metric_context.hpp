@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "image.hpp"
+
+inline constexpr size_t METRIC_BUFFER_ALIGNMENT{64}; // a cache line, also enough for any SIMD load
+
+template <typename T>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U> &) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{METRIC_BUFFER_ALIGNMENT})); }
+    void deallocate(T *p, size_t) { ::operator delete(p, std::align_val_t{METRIC_BUFFER_ALIGNMENT}); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U> &) const { return true; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Expands 8-bit channel values to linear floats the same way stbi_loadf does for LDR images (gamma 2.2)
+const std::array<float, 256> &ldrToFloatTable();
+
+class SSIMReference;
+
+// How far a native metric engine is from the library it replaces on one image pair
+struct MetricDifference
+{
+    float nativeMean = 0.0f;
+    float libraryMean = 0.0f;
+    float maxPixelDifference = 0.0f; // largest difference between the two error maps
+};
+
+// Scratch buffers for evaluating the pixel metrics. The buffers grow to the largest image seen and are reused, so
+// repeated evaluations do not allocate. A context is not shared between threads, keep one per worker.
+// Error maps are only written when a path is given, callers running in parallel must give each call its own path.
+class MetricContext
+{
+public:
+    float evaluateSSIM(const ImageView &img1, const ImageView &img2, const char *errorMapPath = nullptr);
+    // Native SSIM, the reference side comes prepared. The error map covers the window positions.
+    float evaluateSSIM(const SSIMReference &reference, const ImageView &img, const char *errorMapPath = nullptr);
+    // Native SSIM against rmgr on the same pair, the maps are compared channel by channel
+    MetricDifference compareSSIM(const ImageView &refImg, const ImageView &img);
+    float evaluateFLIP(const ImageView &img1, const ImageView &img2, const char *errorMapPath = nullptr);
+
+private:
+    // Writes 1 - map normalized to [0, 255] as a grayscale PNG, the map is modified in place
+    void saveErrorMap(float *errorMap, int width, int height, const char *path);
+
+    AlignedVector<float> ssimMap;
+    AlignedVector<float> nativeSSIMMap; // interleaved channels
+    AlignedVector<float> img1Float;
+    AlignedVector<float> img2Float;
+    AlignedVector<float> flipErrorMap;
+    std::vector<uint8_t> errorMapPixels;
+};
@@ -51,6 +51,7 @@ public:
     }
 
     void setCurveSelected(int curveIdx, glm::vec3 color);
+    AABB getAABB() const { return aabb; }
     bool contains(glm::vec2 pos) const
     {
         return aabb.contains(pos);
@@ -66,9 +67,12 @@ public:
             aabb.max.x, aabb.min.y, col[0], col[1], col[2]};
     }
     Vertex findPatchPoint(float u, float v) const;
+    // Distance from P to the closest point of the patch found by Newton iteration on the bicubic map, 0 when inside
     double isPointInsidePatch(const glm::vec2 &P, double tolerance = 0.01) const;
 
 private:
+    // Position and partial derivatives of the patch at (u, v), coordinates only
+    glm::vec2 evaluateCoords(float u, float v, glm::vec2 &du, glm::vec2 &dv) const;
     void populateCurveData(std::array<int, 4> halfEdgeIdxs);
 
     std::vector<Vertex> controlMatrix = std::vector<Vertex>(16);
@@ -97,8 +101,6 @@ const std::vector<GLfloat> getAllPatchGLData(const std::vector<Patch> &patches,
 const std::vector<GLfloat> getAllHandleGLPoints(const std::vector<Vertex> &handles, int firstIdx = 0, int step = 1);
 const std::vector<GLfloat> getAllPatchGLControlPointData(std::vector<Vertex> &points, std::optional<glm::vec3> color);
 int getSelectedPatch(const std::vector<Patch> &patches, glm::vec2 pos);
-int getPatchFromFaceIdx(const std::vector<Patch> &patches, int faceIdx);
-CurveId getCurveIdFromEdgeIdx(const std::vector<Patch> &patches, int targetEdgeIdx);
 
 using Int4x4 = std::array<std::array<int, 4>, 4>;
 inline constexpr Int4x4 patchCurveIndices = {{{0, 1, 2, 3},
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "dirty_list.hpp"
+#include "patch.hpp"
+
+class GradMesh;
+
+// Patches of a GradMesh keyed by face index. The mesh marks every element it hands out through its edit* accessors
+// (and every element a rollback, undo or redo restores), update() then regenerates only the faces whose patch can
+// depend on a marked element: the faces of the marked edges and of the child edges that interpolate their curves.
+class PatchCache
+{
+public:
+    void markEdge(int idx) { dirtyEdges.mark(idx); }
+    void markHandle(int idx) { dirtyHandles.mark(idx); }
+    void markFace(int idx) { dirtyFaces.mark(idx); }
+
+    // Brings the cached patches up to date with the mesh, returns false if a valid face has no patch
+    bool update(const GradMesh &mesh);
+    // Valid faces in face order, like GradMesh::generatePatches
+    std::vector<Patch> getPatches() const;
+    const std::vector<std::optional<Patch>> &getFacePatches() const { return facePatches; }
+    // Changes whenever the face's patch is regenerated, unique across caches so a copied mesh never aliases
+    const std::vector<uint64_t> &getFaceVersions() const { return faceVersions; }
+
+private:
+    void rebuild(const GradMesh &mesh);
+    const std::vector<int> &collectDirtyFaces(const GradMesh &mesh);
+    void updateParentIndex(const GradMesh &mesh);
+    void indexParent(const GradMesh &mesh, int edgeIdx);
+    void unindexParent(int edgeIdx);
+
+    bool built = false;
+    std::vector<std::optional<Patch>> facePatches;
+    std::vector<uint64_t> faceVersions;
+    DirtyList dirtyEdges;
+    DirtyList dirtyHandles;
+    DirtyList dirtyFaces;
+
+    // A child edge interpolates getCurve(parent), which reads the origin of the parent's next edge, and that edge does not
+    // link back to the parent (its prevIdx is a child). Parents are listed by their next edge in intrusive lists that
+    // are kept up to date from the marked edges.
+    std::vector<int> firstParentByNext; // per edge, a parent whose next edge it is, or -1
+    std::vector<int> nextParentByNext;  // per parent, the next parent in the list of its next edge, or -1
+    std::vector<int> indexedNextIdx;    // per edge, the next edge it is listed under, or -1
+
+    // scratch of collectDirtyFaces, the flags of the last call are cleared at the start of the next
+    std::vector<char> faceSeen;
+    std::vector<char> edgeSeen;
+    std::vector<int> dirtyFaceIdxs;
+    std::vector<int> seenEdgeIdxs;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "patch.hpp"
+#include "types.hpp"
+
+// Uniform grid over the patch AABBs for picking. Each cell lists the patches whose AABB overlaps it, so a query only
+// looks at the few patches around the cursor instead of all of them. The curve AABBs of a patch lie inside its own, so
+// the same cells also find the curves. Rebuild after the patches are regenerated.
+class PatchIndex
+{
+public:
+    void build(const std::vector<Patch> &patches);
+    void clear();
+    // Patches whose AABB may contain the point, in increasing index order
+    std::span<const int> candidates(glm::vec2 pos) const;
+    size_t numPatches() const { return indexedPatches; }
+
+private:
+    std::pair<int, int> cellCoords(glm::vec2 pos) const;
+
+    AABB bounds;
+    glm::vec2 cellSize{1.0f};
+    int cellsX = 0;
+    int cellsY = 0;
+    size_t indexedPatches = 0;
+    std::vector<int> cellStart; // CSR offsets into cellPatches, one past the last cell at the end
+    std::vector<int> cellPatches;
+};
+
+// Dense face -> patch and half-edge -> curve maps of a patch vector, rebuild after the patches are regenerated
+class PatchLookup
+{
+public:
+    void build(const std::vector<Patch> &patches);
+    int patchOfFace(int faceIdx) const;
+    CurveId curveOfEdge(int halfEdgeIdx) const;
+
+private:
+    std::vector<int> facePatches;    // -1 for faces without a patch
+    std::vector<CurveId> edgeCurves; // {-1, -1} for edges that are no patch's curve
+};
+
+// Picks through the index, falls back to the linear scan when the index is out of date
+int getSelectedPatch(const std::vector<Patch> &patches, const PatchIndex &index, glm::vec2 pos);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "gms_appstate.hpp"
+#include "gradmesh.hpp"
+
+// Rewrites the topology and geometry of a mesh to merge the two faces of a half-edge. It only touches the mesh it is
+// given, so each thread can merge on its own copy.
+class PatchMerger
+{
+public:
+    explicit PatchMerger(GradMesh &mesh) : mesh(mesh) {}
+    GmsAppState::MergeStats merge(int mergeEdgeIdx);
+
+private:
+    float splittingFactor(HalfEdge &stem, HalfEdge &bar1, HalfEdge &bar2, int sign) const;
+    bool addTJunction(int bar1Idx, int bar2Idx, int twinOfParentIdx, float t);
+
+    void leftTUpdateInterval(int parentIdx, float totalCurve);
+    void rightTUpdateInterval(int parentIdx, float reparam1, float reparam2);
+    void scaleDownChildrenByT(HalfEdge &parentEdge, float t);
+    void scaleUpChildrenByT(HalfEdge &parentEdge, float t);
+
+    void setChildrenNewParent(HalfEdge &parentEdge, int newParentIdx);
+    void setParentChildrenTwin(HalfEdge &parentEdge, int newTwinIdx);
+    void childBecomesItsParent(int childIdx);
+    void setBarChildrensTwin(HalfEdge &parentEdge, int twinIdx);
+    void setNextRightL(const HalfEdge &bar, int nextIdx);
+
+    void transferChildTo(int oldChildIdx, int newChildIdx);
+    void transferChildToWithoutGeometry(int oldChildIdx, int newChildIdx);
+    void fixAndSetTwin(int barIdx);
+
+    void copyEdgeTwin(int e1Idx, int e2Idx);
+    void removeFace(int faceIdx);
+
+    GradMesh &mesh;
+};
+
+inline int getCornerTJunctions(bool topLeftL, bool topLeftT, bool topRightL, bool topRightT, bool isStem)
+{
+    if (isStem)
+        return IsStem;
+
+    int flags = None;
+    if (topLeftL)
+        flags |= LeftL;
+    if (topLeftT)
+        flags |= LeftT;
+    if (topRightL)
+        flags |= RightL;
+    if (topRightT)
+        flags |= RightT;
+    return flags;
+};
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include "image.hpp"
+#include "types.hpp"
+
+inline constexpr int PATCH_TESS_LEVEL{16}; // must match the tessellation level in patch.tcs.glsl
+inline constexpr int GL_FLOATS_PER_VERTEX{5};
+
+// Software counterpart of the patch shader pipeline (patch.vs/tcs/tes/fs.glsl) so merges can be scored without a GL context.
+// glPatches uses the same layout as getAllPatchGLData(patches, &Patch::getControlMatrix). The image is cleared to white and
+// written with rows bottom-up, matching glReadPixels on an FBO rendered with drawPrimitive(..., aabb, VERTS_PER_PATCH).
+void rasterizePatches(const std::vector<float> &glPatches, const AABB &aabb, int width, int height, Image &image);
+
+struct ImageDifference
+{
+    int differingPixels = 0; // pixels with a channel that differs by more than the tolerance
+    int maxChannelDifference = 0;
+};
+ImageDifference compareImages(const ImageView &img1, const ImageView &img2, int tolerance = 0);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+class GradMesh;
+class Patch;
+
+// Patch control points of a GradMesh laid out like getAllPatchGLData(patches, &Patch::getControlMatrix), but with one
+// fixed slot per face so a merge only rewrites the slots of the faces it touched. Slots of removed faces are zeroed,
+// a degenerate patch covers no pixels, so draw order stays face order without ever compacting the buffer.
+class PatchVertexBuffer
+{
+public:
+    PatchVertexBuffer() = default;
+    ~PatchVertexBuffer();
+    PatchVertexBuffer(const PatchVertexBuffer &) = delete;
+    PatchVertexBuffer &operator=(const PatchVertexBuffer &) = delete;
+
+    // Syncs the slots with the mesh's patch cache, returns false if a valid face has no patch
+    bool update(const GradMesh &mesh);
+    const std::vector<GLfloat> &getData() const { return data; }
+    int numVertices() const { return static_cast<int>(data.size()) / 5; }
+    // Binds the GL buffer with the patch vertex layout, uploading only the slots that changed since the last bind
+    void bind();
+
+private:
+    void writeSlot(int faceIdx, const Patch *patch); // nullptr zeroes the slot
+
+    std::vector<GLfloat> data;
+    std::vector<uint64_t> slotVersions; // patch cache version each slot was written from
+    std::vector<int> dirtySlots;
+    size_t uploadedSize = 0;
+    GLuint vbo = 0; // created on first bind so the CPU backend never touches GL
+};
@@ -1,14 +1,37 @@
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 #include <omp.h>
 #include <queue>
 #include <set>
 #include <iterator>
+#include <numeric>
+#include <span>
 
+#include "conflict_graph.hpp"
+#include "dense_bitset.hpp"
 #include "gms_appstate.hpp"
 #include "gradmesh.hpp"
+#include "independent_set.hpp"
 #include "merging.hpp"
 
+inline constexpr int SINGLE_MERGE_BATCH_SIZE{100};
+inline constexpr int PRODUCT_REGION_BATCH_SIZE{8}; // edge regions per worker and frame
+inline constexpr int THRESHOLD_SEARCH_STEPS{10};
+
+// Mesh copy with its own render target and metric context, one per thread of a CPU backend pass
+struct MeshWorker
+{
+    explicit MeshWorker(const GradMesh &mesh) : mesh(mesh) {}
+    GradMesh mesh;
+    PatchVertexBuffer patchBuffer;
+    Image image;
+    Image previous; // local AABB before a trial merge
+    MetricContext metricContext;
+    IncrementalSSIM globalSSIM;
+};
+
 class MergePreprocessor
 {
     struct TPRNodePair
@@ -18,6 +41,32 @@ class MergePreprocessor
         float score;
     };
 
+    struct PairScores
+    {
+        float eps;
+        float w;
+        float numFaces;
+        std::vector<float> scores; // per TPR, the best of its own score and its pair scores
+    };
+
+    // TPRs picked for one error threshold
+    struct RegionSelection
+    {
+        void add(int idx)
+        {
+            ids.push_back(idx);
+            picked.set(idx);
+        }
+        std::vector<int> ids; // sorted once selected
+        DenseBitset picked;
+    };
+
+    struct ThresholdResult
+    {
+        int numFaces;
+        float mergeError;
+    };
+
 public:
     MergePreprocessor(GradMeshMerger &merger, GmsAppState &appState) : merger(merger), appState(appState), mesh(appState.mesh), edgeRegions(appState.edgeRegions)
     {
@@ -32,19 +81,35 @@ public:
     void mergeMotorcycle();
 
 private:
-    std::vector<RegionAttributes> findMaxProductRegion(EdgeRegion &edgeRegion);
-    std::vector<RegionAttributes> mergeRow(int currEdgeIdx, AABB &aabb, bool isRow = true, int maxLength = std::numeric_limits<int>::max(), int oppLength = 0);
-    int mergeRowWithoutError(int currEdgeIdx, int maxLength = std::numeric_limits<int>::max());
-    void mergeEdgeRegion(const Region &region);
+    void beginSingleMergeSweep();
+    void endSingleMergeSweep();
+    void scoreSingleMergesInParallel();
+    float scoreSingleMerge(MetricContext &context, const ImageView &image, int candidateIdx) const;
+    void findProductRegionsInParallel();
+    void endProductRegionSweep();
+    void cancelProductRegionSweep();
+    // The worker's mesh copy is merged instead of the app mesh when it is given
+    std::vector<RegionAttributes> findMaxProductRegion(EdgeRegion &edgeRegion, MeshWorker *worker = nullptr);
+    float attemptMerge(MeshWorker *worker, int currEdgeIdx, AABB &aabb);
+    std::vector<RegionAttributes> mergeRow(MeshWorker *worker, int currEdgeIdx, AABB &aabb, bool isRow = true, int maxLength = std::numeric_limits<int>::max(), int oppLength = 0);
+    int mergeRowWithoutError(GradMesh &target, int currEdgeIdx, int maxLength = std::numeric_limits<int>::max()) const;
+    void mergeEdgeRegion(GradMesh &target, const Region &region) const;
     void mergeEdgeRegionWithError(const Region &region);
     std::vector<EdgeRegion> getEdgeRegions(const std::vector<std::pair<int, int>> &startPairs);
-    void findAllRegions(const std::vector<int> &rowIdxs, int rowLength, AABB &errorAABB, std::vector<RegionAttributes> &regionAttributes);
+    void findAllRegions(MeshWorker *worker, const std::vector<int> &rowIdxs, int rowLength, AABB &errorAABB, std::vector<RegionAttributes> &regionAttributes);
     void createAdjList();
-    bool canInclude(int idx);
+    bool canInclude(const RegionSelection &selection, int idx) const;
+    void improveIndependentSet(float eps, RegionSelection &selection) const;
+    const std::vector<float> &bestPairScores(float eps, float w, float numFaces);
     int binarySearch(const std::vector<int> &arr, int left, float eps);
 
-    void greedyQuadErrorHeuristic(float eps);
-    void greedyQuadErrorOneStep(float userError);
+    void searchThreshold(bool oneStep);
+    ThresholdResult evaluateThreshold(float eps, bool oneStep, float numFaces);
+    std::vector<ThresholdResult> evaluateThresholdsInParallel(std::vector<std::unique_ptr<MeshWorker>> &workers, const std::vector<float> &thresholds, bool oneStep, float numFaces);
+    RegionSelection selectRegions(float eps, bool oneStep, float numFaces);
+    void mergeRegions(GradMesh &target, std::span<const int> tprIdxs) const;
+    void greedyQuadErrorHeuristic(float eps, float numFaces, RegionSelection &selection) const;
+    void greedyQuadErrorOneStep(float eps, float numFaces, RegionSelection &selection);
     void computeConflictGraphStats();
 
     GradMeshMerger &merger;
@@ -56,7 +121,13 @@ private:
     std::vector<std::pair<int, int>> meshCornerFaces;
 
     std::vector<TPRNode> allTPRs;
-    std::vector<std::vector<int>> adjList;
-    std::set<int> currIndependentSet;
-    std::set<int>::iterator currIndependentSetIterator;
+    ConflictGraph adjList;
+    std::vector<int> currIndependentSet; // sorted once selected
+    std::vector<int>::iterator currIndependentSetIterator;
+    std::vector<PairScores> pairScoreCache;
+
+    std::vector<Image> candidateImages; // single merge captures awaiting evaluation, one batch at a time
+    std::vector<MetricContext> metricContexts; // one per OpenMP thread scoring candidateImages
+    std::vector<std::unique_ptr<MeshWorker>> singleMergeWorkers; // only while a CPU backend sweep runs
+    std::vector<std::unique_ptr<MeshWorker>> productRegionWorkers; // only while a CPU backend sweep runs
 };
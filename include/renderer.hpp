@@ -10,6 +10,7 @@
 #include "window.hpp"
 
 class GmsAppState;
+class PatchVertexBuffer;
 
 class GmsRenderer
 {
@@ -36,7 +37,8 @@ private:
 void initializeOpenGL();
 void setUniformProjectionMatrix(GLuint shaderId, glm::mat4 &projectionMatrix);
 void setLineColor(GLuint shaderId, const glm::vec3 &color);
-void setVertexData(const std::vector<GLfloat> vertexData);
+void setVertexData(const std::vector<GLfloat> &vertexData);
 void setProjectionMatrixAABB(int shaderId, AABB aabb);
 void drawPrimitive(const std::vector<GLfloat> &glData, int shaderId, glm::mat4 &projectionMatrix, int vertsPerPrimitive);
-void drawPrimitive(const std::vector<GLfloat> &glData, int shaderId, const AABB &aabb, int vertsPerPrimitive);
\ No newline at end of file
+void drawPrimitive(const std::vector<GLfloat> &glData, int shaderId, const AABB &aabb, int vertsPerPrimitive);
+void drawPrimitive(PatchVertexBuffer &patchBuffer, int shaderId, const AABB &aabb);
\ No newline at end of file
@@ -54,18 +54,6 @@ struct DoubleHalfEdge
     }
 };
 
-inline int findDoubleHalfEdgeIndex(const std::vector<DoubleHalfEdge> &edges, int halfEdgeIdx)
-{
-    auto it = std::find_if(edges.begin(), edges.end(), [halfEdgeIdx](const DoubleHalfEdge &dhe)
-                           { return dhe.halfEdgeIdx1 == halfEdgeIdx || dhe.halfEdgeIdx2 == halfEdgeIdx; });
-
-    if (it != edges.end())
-    {
-        return static_cast<int>(std::distance(edges.begin(), it));
-    }
-    return -1;
-}
-
 struct AABB
 {
     glm::vec2 min;
@@ -221,20 +209,30 @@ struct Vertex
                          color.r * color.r + color.g * color.g + color.b * color.b);
     }
 };
+// Slice of GradMesh's child arena. A list is never changed in place, editing one writes a new slice, so a journaled
+// copy of the half-edge keeps pointing at its old children.
+struct ChildRange
+{
+    int first = 0;
+    int count = 0;
+};
+
+// Topology first, the traversals mostly read only the first cache line. The child list lives in the mesh's arena, so a
+// half-edge is trivially copyable and copying a mesh does not allocate per edge.
 struct HalfEdge
 {
-    glm::vec2 interval = {0, 1};
-    Vertex twist;
-    glm::vec3 color;
-    std::pair<int, int> handleIdxs;
     int twinIdx;
     int prevIdx;
     int nextIdx;
     int faceIdx;
     int originIdx;
     int parentIdx = -1;
-    std::vector<int> childrenIdxs = {};
     int childIdxDegenerate = -1;
+    ChildRange children;
+    std::pair<int, int> handleIdxs;
+    glm::vec2 interval = {0, 1};
+    Vertex twist;
+    glm::vec3 color;
 
     bool isValid() const
     {
@@ -254,7 +252,7 @@ struct HalfEdge
     }
     bool isParent() const
     {
-        return childrenIdxs.size() > 0;
+        return children.count > 0;
     }
     bool isStemParent() const
     {
@@ -287,19 +285,6 @@ struct HalfEdge
         this->parentIdx = other.parentIdx;
         this->interval = other.interval;
     }
-    void replaceChild(int oldChildIdx, int newChildIdx)
-    {
-        std::replace(childrenIdxs.begin(), childrenIdxs.end(), oldChildIdx, newChildIdx);
-        // auto endIt = std::unique(childrenIdxs.begin(), childrenIdxs.end());
-        // childrenIdxs.erase(endIt, childrenIdxs.end());
-    }
-    void addChildrenIdxs(std::vector<int> newChildren)
-    {
-        for (const int &child : newChildren)
-            // Check if the child is not already in childrenIdxs
-            if (std::find(childrenIdxs.begin(), childrenIdxs.end(), child) == childrenIdxs.end())
-                childrenIdxs.push_back(child); // Add only if not found
-    }
     void createStem(int newParentIdx, glm::vec2 newInterval)
     {
         originIdx = -1;
@@ -311,11 +296,6 @@ struct HalfEdge
         createStem(newParentIdx, newInterval);
         handleIdxs = {-1, -1};
     }
-    void removeChildIdx(int childIdx)
-    {
-        auto it = std::remove(childrenIdxs.begin(), childrenIdxs.end(), childIdx);
-        childrenIdxs.erase(it, childrenIdxs.end());
-    }
 };
 
 inline std::vector<int> getValidCompIndices(const auto &comps)
@@ -378,6 +358,7 @@ inline const char *PREV_METRIC_IMG{"img/prevMesh.png"};
 inline const char *ORIG_IMG{"img/origImage.png"};
 inline const char *CURR_IMG{"img/currImage.png"};
 inline const char *EDGE_MAP_IMG{"img/errorEdgeMap.png"};
+inline const char *ERROR_MAP_IMG{"img/errormap.png"};
 inline constexpr int MAX_CURVE_DEPTH = 1000;
 
 inline constexpr glm::vec3 blue{0.0f, 0.478f, 1.0f};
@@ -0,0 +1,204 @@
+#include "candidate_merges.hpp"
+#include "gradmesh.hpp"
+
+void CandidateMerges::rebuild(GradMesh &mesh)
+{
+    const auto &edges = mesh.getEdges();
+    merges.clear();
+    firstSlot.assign(edges.size(), -1);
+    secondSlot.assign(edges.size(), -1);
+    numUntried = 0;
+
+    for (const auto &face : mesh.getFaces())
+    {
+        if (!face.isValid())
+            continue;
+        int currIdx = face.halfEdgeIdx;
+        for (int i = 0; i < 4; i++)
+        {
+            if (ownerOf(mesh, currIdx) == currIdx)
+                insert(currIdx, edges[currIdx].twinIdx);
+            currIdx = edges[currIdx].nextIdx;
+        }
+    }
+    mesh.takeChangedEdges([](int) {});
+    curveIdsStale = true;
+    resolveCurveIds(mesh);
+}
+
+void CandidateMerges::update(GradMesh &mesh)
+{
+    const auto &edges = mesh.getEdges();
+    recheck.clear();
+    mesh.takeChangedEdges([this](int idx)
+                          { recheck.push_back(idx); });
+    if (recheck.empty() && firstSlot.size() == edges.size())
+        return;
+    curveIdsStale = true;
+
+    // entries with a half a rollback dropped go first, their other half is rechecked below
+    for (size_t idx = edges.size(); idx < firstSlot.size(); idx++)
+    {
+        while (firstSlot[idx] != -1 || secondSlot[idx] != -1)
+        {
+            int slot = firstSlot[idx] != -1 ? firstSlot[idx] : secondSlot[idx];
+            recheck.push_back(merges[slot].halfEdgeIdx1);
+            recheck.push_back(merges[slot].halfEdgeIdx2);
+            erase(slot);
+        }
+    }
+    firstSlot.resize(edges.size(), -1);
+    secondSlot.resize(edges.size(), -1);
+
+    // whether an edge can be merged also depends on its twin, and an entry on both of its halves
+    const size_t numChanged = recheck.size();
+    for (size_t i = 0; i < numChanged; i++)
+    {
+        int idx = recheck[i];
+        if (idx < 0 || static_cast<size_t>(idx) >= edges.size())
+            continue;
+        recheck.push_back(edges[idx].twinIdx);
+        if (firstSlot[idx] != -1)
+            recheck.push_back(merges[firstSlot[idx]].halfEdgeIdx2);
+        if (secondSlot[idx] != -1)
+            recheck.push_back(merges[secondSlot[idx]].halfEdgeIdx1);
+    }
+
+    // drop the stale entries before adding, a pair whose entry moved to its other half then never collides
+    for (int idx : recheck)
+    {
+        if (idx < 0 || static_cast<size_t>(idx) >= edges.size() || firstSlot[idx] == -1)
+            continue;
+        int slot = firstSlot[idx];
+        if (ownerOf(mesh, idx) != idx || merges[slot].halfEdgeIdx2 != edges[idx].twinIdx)
+            erase(slot);
+    }
+    for (int idx : recheck)
+    {
+        if (idx < 0 || static_cast<size_t>(idx) >= edges.size() || firstSlot[idx] != -1)
+            continue;
+        if (ownerOf(mesh, idx) == idx)
+            insert(idx, edges[idx].twinIdx);
+    }
+}
+
+void CandidateMerges::resolveCurveIds(const GradMesh &mesh)
+{
+    if (!curveIdsStale)
+        return;
+    // patches are the valid faces in face order
+    const auto &faces = mesh.getFaces();
+    std::vector<int> patchIdxs(faces.size(), -1);
+    int patchIdx = 0;
+    for (size_t faceIdx = 0; faceIdx < faces.size(); faceIdx++)
+        if (faces[faceIdx].isValid())
+            patchIdxs[faceIdx] = patchIdx++;
+
+    for (auto &dhe : merges)
+    {
+        dhe.curveId1 = curveOf(mesh, patchIdxs, dhe.halfEdgeIdx1);
+        dhe.curveId2 = ownerOf(mesh, dhe.halfEdgeIdx2) == dhe.halfEdgeIdx1 ? curveOf(mesh, patchIdxs, dhe.halfEdgeIdx2) : CurveId{-1, -1};
+    }
+    curveIdsStale = false;
+}
+
+int CandidateMerges::find(int halfEdgeIdx) const
+{
+    if (halfEdgeIdx < 0 || static_cast<size_t>(halfEdgeIdx) >= firstSlot.size())
+        return -1;
+    return firstSlot[halfEdgeIdx] != -1 ? firstSlot[halfEdgeIdx] : secondSlot[halfEdgeIdx];
+}
+
+int CandidateMerges::pickUntried(std::mt19937 &gen)
+{
+    if (numUntried == 0)
+        return -1;
+    std::uniform_int_distribution<size_t> distrib(0, numUntried - 1);
+    swapSlots(distrib(gen), --numUntried);
+    return static_cast<int>(numUntried);
+}
+
+int CandidateMerges::ownerOf(const GradMesh &mesh, int halfEdgeIdx)
+{
+    if (halfEdgeIdx < 0 || !mesh.validMergeEdge(halfEdgeIdx) || !onFaceLoop(mesh, halfEdgeIdx))
+        return -1;
+    const auto &edges = mesh.getEdges();
+    int twinIdx = edges[halfEdgeIdx].twinIdx;
+    if (edges[twinIdx].twinIdx == halfEdgeIdx && edges[twinIdx].faceIdx < edges[halfEdgeIdx].faceIdx && mesh.validMergeEdge(twinIdx) &&
+        onFaceLoop(mesh, twinIdx))
+        return twinIdx;
+    return halfEdgeIdx;
+}
+
+// Some meshes have edges that keep the index of a face, even a removed one, without being on its loop. A face-order scan
+// never meets them, so an update must not list them either.
+bool CandidateMerges::onFaceLoop(const GradMesh &mesh, int halfEdgeIdx)
+{
+    const auto &edges = mesh.getEdges();
+    int currIdx = mesh.getFaces()[edges[halfEdgeIdx].faceIdx].halfEdgeIdx;
+    for (int i = 0; i < 4 && currIdx != -1; i++)
+    {
+        if (currIdx == halfEdgeIdx)
+            return true;
+        currIdx = edges[currIdx].nextIdx;
+    }
+    return false;
+}
+
+CurveId CandidateMerges::curveOf(const GradMesh &mesh, const std::vector<int> &patchIdxs, int halfEdgeIdx)
+{
+    const auto &edges = mesh.getEdges();
+    int faceIdx = edges[halfEdgeIdx].faceIdx;
+    int currIdx = mesh.getFaces()[faceIdx].halfEdgeIdx;
+    for (int i = 0; i < 4; i++)
+    {
+        if (currIdx == halfEdgeIdx)
+            return CurveId{patchIdxs[faceIdx], i};
+        currIdx = edges[currIdx].nextIdx;
+    }
+    return CurveId{-1, -1};
+}
+
+// New entries join the untried ones
+void CandidateMerges::insert(int halfEdgeIdx, int twinIdx)
+{
+    DoubleHalfEdge dhe{halfEdgeIdx, twinIdx, CurveId{-1, -1}};
+    dhe.curveId2 = CurveId{-1, -1};
+    dhe.error = 0.0f;
+    merges.push_back(dhe);
+    setSlot(merges.size() - 1);
+    swapSlots(numUntried++, merges.size() - 1);
+}
+
+void CandidateMerges::erase(size_t slot)
+{
+    if (slot < numUntried)
+    {
+        swapSlots(slot, --numUntried);
+        slot = numUntried;
+    }
+    swapSlots(slot, merges.size() - 1);
+    const auto &dhe = merges.back();
+    firstSlot[dhe.halfEdgeIdx1] = -1;
+    if (dhe.halfEdgeIdx2 >= 0 && static_cast<size_t>(dhe.halfEdgeIdx2) < secondSlot.size() &&
+        secondSlot[dhe.halfEdgeIdx2] == static_cast<int>(merges.size() - 1))
+        secondSlot[dhe.halfEdgeIdx2] = -1;
+    merges.pop_back();
+}
+
+void CandidateMerges::swapSlots(size_t a, size_t b)
+{
+    if (a == b)
+        return;
+    std::swap(merges[a], merges[b]);
+    setSlot(a);
+    setSlot(b);
+}
+
+void CandidateMerges::setSlot(size_t slot)
+{
+    const auto &dhe = merges[slot];
+    firstSlot[dhe.halfEdgeIdx1] = static_cast<int>(slot);
+    if (dhe.halfEdgeIdx2 >= 0 && static_cast<size_t>(dhe.halfEdgeIdx2) < secondSlot.size())
+        secondSlot[dhe.halfEdgeIdx2] = static_cast<int>(slot);
+}
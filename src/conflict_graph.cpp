@@ -0,0 +1,173 @@
+#include "conflict_graph.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "mapped_file.hpp"
+
+namespace
+{
+    struct OwnedArrays
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<int> neighbours;
+    };
+}
+
+ConflictGraph::ConflictGraph(const std::vector<std::vector<int>> &neighbourLists)
+{
+    auto arrays = std::make_shared<OwnedArrays>();
+    arrays->offsets.reserve(neighbourLists.size() + 1);
+    arrays->offsets.push_back(0);
+    for (const auto &list : neighbourLists)
+        arrays->offsets.push_back(arrays->offsets.back() + list.size());
+    arrays->neighbours.reserve(arrays->offsets.back());
+    for (const auto &list : neighbourLists)
+        arrays->neighbours.insert(arrays->neighbours.end(), list.begin(), list.end());
+
+    offsets = arrays->offsets;
+    neighbours = arrays->neighbours;
+    storage = std::move(arrays);
+}
+
+ConflictGraph::ConflictGraph(std::span<const uint32_t> offsets, std::span<const int> neighbours, std::shared_ptr<const void> storage)
+    : storage{std::move(storage)}, offsets{offsets}, neighbours{neighbours}
+{
+}
+
+bool isConflictGraphBinaryFile(const std::string &filename)
+{
+    return filename.ends_with(TPRB_EXTENSION);
+}
+
+void readConflictGraphBinaryFile(const std::string &filename, std::vector<TPRNode> &allTPRs, ConflictGraph &adjList, std::vector<EdgeRegion> &sortedRegions)
+{
+    auto file = std::make_shared<MappedFile>(filename);
+    size_t offset = 0;
+
+    auto header = readRecords<tprb::Header>(*file, offset, 1)[0];
+    if (std::memcmp(header.magic, TPRB_MAGIC, sizeof(TPRB_MAGIC)) != 0)
+        throw std::runtime_error("Not a binary conflict graph file\n");
+    if (header.version != TPRB_VERSION)
+        throw std::runtime_error("Unsupported binary conflict graph version " + std::to_string(header.version) + "\n");
+
+    auto nodes = viewRecords<tprb::NodeRecord>(*file, offset, header.numNodes);
+    auto offsets = viewRecords<uint32_t>(*file, offset, static_cast<size_t>(header.numNodes) + 1);
+    auto neighbours = viewRecords<int32_t>(*file, offset, header.numNeighbours);
+    auto regions = viewRecords<tprb::RegionRecord>(*file, offset, header.numRegions);
+    auto attributes = viewRecords<tprb::AttributeRecord>(*file, offset, header.numAttributes);
+
+    // the spans index the neighbours and the TPRs without further checks, so the offsets and ids are validated once here
+    if (offsets[0] != 0 || offsets[header.numNodes] != header.numNeighbours)
+        throw std::runtime_error("Binary conflict graph file has invalid offsets\n");
+    for (size_t i = 0; i < header.numNodes; i++)
+    {
+        if (offsets[i] > offsets[i + 1])
+            throw std::runtime_error("Binary conflict graph file has invalid offsets\n");
+    }
+    for (int32_t neighbour : neighbours)
+    {
+        if (neighbour < 0 || static_cast<uint32_t>(neighbour) >= header.numNodes)
+            throw std::runtime_error("Binary conflict graph file has an invalid neighbour\n");
+    }
+
+    // the outputs are only replaced once the whole file is read
+    std::vector<TPRNode> fileTPRs;
+    fileTPRs.reserve(nodes.size());
+    for (const auto &n : nodes)
+    {
+        if (n.id < 0 || static_cast<uint32_t>(n.id) >= header.numNodes)
+            throw std::runtime_error("Binary conflict graph file has an invalid TPR id\n");
+        TPRNode node;
+        node.id = n.id;
+        node.gridPair = {n.gridPair[0], n.gridPair[1]};
+        node.maxRegion = {n.maxRegion[0], n.maxRegion[1]};
+        node.error = n.error;
+        node.maxChainLength = n.maxChainLength;
+        node.degree = n.degree;
+        fileTPRs.push_back(node);
+    }
+
+    std::vector<EdgeRegion> fileRegions;
+    fileRegions.reserve(regions.size());
+    for (const auto &r : regions)
+    {
+        if (static_cast<size_t>(r.firstAttribute) + r.numAttributes > attributes.size())
+            throw std::runtime_error("Binary conflict graph file has an invalid attribute range\n");
+
+        EdgeRegion edgeRegion;
+        edgeRegion.gridPair = {r.gridPair[0], r.gridPair[1]};
+        edgeRegion.faceIdx = r.faceIdx;
+        edgeRegion.allRegionAttributes.reserve(r.numAttributes);
+        for (const auto &a : attributes.subspan(r.firstAttribute, r.numAttributes))
+        {
+            RegionAttributes region;
+            region.maxRegion = {a.maxRegion[0], a.maxRegion[1]};
+            region.error = a.error;
+            region.maxChainLength = a.maxChainLength;
+            region.maxRegionAABB = AABB{glm::vec2(a.aabb[0], a.aabb[1]), glm::vec2(a.aabb[2], a.aabb[3])};
+            edgeRegion.allRegionAttributes.push_back(region);
+        }
+        fileRegions.push_back(std::move(edgeRegion));
+    }
+
+    allTPRs = std::move(fileTPRs);
+    sortedRegions = std::move(fileRegions);
+    // the adjacency is used in place, the graph keeps the mapping alive
+    adjList = ConflictGraph{offsets, neighbours, std::move(file)};
+}
+
+void writeConflictGraphBinaryFile(const std::string &filename, const std::vector<TPRNode> &allTPRs, const ConflictGraph &adjList, const std::vector<EdgeRegion> &sortedRegions)
+{
+    // the node table and the offsets share their count
+    if (adjList.size() != allTPRs.size())
+        throw std::runtime_error("Conflict graph does not match its TPRs\n");
+    std::ofstream out{filename, std::ios::binary};
+    if (!out)
+    {
+        throw std::runtime_error("File could not be opened for writing\n");
+    }
+
+    std::vector<tprb::NodeRecord> nodes;
+    nodes.reserve(allTPRs.size());
+    for (const auto &n : allTPRs)
+        nodes.push_back({n.id, {n.gridPair.first, n.gridPair.second}, {n.maxRegion.first, n.maxRegion.second}, n.error, n.maxChainLength, n.degree});
+
+    std::vector<tprb::RegionRecord> regions;
+    std::vector<tprb::AttributeRecord> attributes;
+    regions.reserve(sortedRegions.size());
+    for (const auto &r : sortedRegions)
+    {
+        regions.push_back({{r.gridPair.first, r.gridPair.second},
+                           r.faceIdx,
+                           static_cast<uint32_t>(attributes.size()),
+                           static_cast<uint32_t>(r.allRegionAttributes.size())});
+        for (const auto &a : r.allRegionAttributes)
+        {
+            const auto &aabb = a.maxRegionAABB;
+            attributes.push_back({{a.maxRegion.first, a.maxRegion.second}, a.error, a.maxChainLength, {aabb.min.x, aabb.min.y, aabb.max.x, aabb.max.y}});
+        }
+    }
+
+    // a default constructed graph has no leading offset
+    std::vector<uint32_t> emptyOffsets{0};
+    auto offsets = adjList.getOffsets().empty() ? std::span<const uint32_t>{emptyOffsets} : adjList.getOffsets();
+
+    tprb::Header header{};
+    std::memcpy(header.magic, TPRB_MAGIC, sizeof(TPRB_MAGIC));
+    header.version = TPRB_VERSION;
+    header.numNodes = nodes.size();
+    header.numNeighbours = adjList.getNeighbours().size();
+    header.numRegions = regions.size();
+    header.numAttributes = attributes.size();
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeRecords(out, nodes);
+    writeRecords(out, offsets);
+    writeRecords(out, adjList.getNeighbours());
+    writeRecords(out, regions);
+    writeRecords(out, attributes);
+    if (!out)
+        throw std::runtime_error("Could not write " + filename + "\n");
+}
@@ -65,20 +65,66 @@ const std::vector<GLfloat> Curve::getGLAABBData() const
         aabb.max.x, aabb.min.y, col[0], col[1], col[2]};
 }
 
+// Branch and bound over de Casteljau halves: a segment lies in the hull of its control points, so its distance is at
+// least the distance to their AABB. Segments that cannot beat the best distance are dropped, flat ones are measured as
+// their chord.
 float Curve::distanceToCurve(const glm::vec2 &point) const
 {
-    int numSamples = 100;
-    float minDistance = std::numeric_limits<float>::max();
-    for (int i = 0; i <= numSamples; ++i)
+    using Segment = std::array<glm::vec2, 4>;
+    const float flatness = 1e-6f;
+    const int maxDepth = 24;
+
+    auto pointSegmentDistance = [&](glm::vec2 a, glm::vec2 b)
+    {
+        glm::vec2 ab = b - a;
+        float lengthSq = glm::dot(ab, ab);
+        float t = lengthSq > 0.0f ? std::clamp(glm::dot(point - a, ab) / lengthSq, 0.0f, 1.0f) : 0.0f;
+        return glm::distance(point, a + t * ab);
+    };
+
+    Segment root{vertices[0].coords, vertices[1].coords, vertices[2].coords, vertices[3].coords};
+    float minDistance = std::min(glm::distance(point, root[0]), glm::distance(point, root[3]));
+    std::vector<std::pair<Segment, int>> stack{{root, 0}};
+    while (!stack.empty())
     {
-        float t = static_cast<float>(i) / numSamples;
-        auto curvePoint = interpolateCubic(vertices[0], vertices[1], vertices[2], vertices[3], t, bezierBasisMat);
-        float distance = glm::distance(point, curvePoint.coords);
+        auto [seg, depth] = stack.back();
+        stack.pop_back();
+
+        glm::vec2 lo = glm::min(glm::min(seg[0], seg[1]), glm::min(seg[2], seg[3]));
+        glm::vec2 hi = glm::max(glm::max(seg[0], seg[1]), glm::max(seg[2], seg[3]));
+        glm::vec2 gap = glm::max(glm::max(lo - point, point - hi), glm::vec2(0.0f));
+        if (glm::length(gap) >= minDistance)
+            continue;
 
-        if (distance < minDistance)
+        float chordDistance = pointSegmentDistance(seg[0], seg[3]);
+        // Flat when the inner control points are within the tolerance of the chord
+        float deviation;
+        glm::vec2 chord = seg[3] - seg[0];
+        float chordLength = glm::length(chord);
+        if (chordLength > 0.0f)
         {
-            minDistance = distance;
+            glm::vec2 normal{-chord.y / chordLength, chord.x / chordLength};
+            deviation = std::max(std::abs(glm::dot(seg[1] - seg[0], normal)), std::abs(glm::dot(seg[2] - seg[0], normal)));
         }
+        else
+        {
+            deviation = std::max(glm::distance(seg[1], seg[0]), glm::distance(seg[2], seg[0]));
+        }
+        if (deviation <= flatness || depth == maxDepth)
+        {
+            minDistance = std::min(minDistance, chordDistance);
+            continue;
+        }
+
+        glm::vec2 p01 = 0.5f * (seg[0] + seg[1]), p12 = 0.5f * (seg[1] + seg[2]), p23 = 0.5f * (seg[2] + seg[3]);
+        glm::vec2 p012 = 0.5f * (p01 + p12), p123 = 0.5f * (p12 + p23);
+        glm::vec2 mid = 0.5f * (p012 + p123);
+        minDistance = std::min(minDistance, glm::distance(point, mid));
+        // Nearer half last so it is refined first and tightens the bound for the other
+        Segment left{seg[0], p01, p012, mid}, right{mid, p123, p23, seg[3]};
+        bool leftFirst = glm::distance(point, 0.5f * (seg[0] + mid)) < glm::distance(point, 0.5f * (mid + seg[3]));
+        stack.push_back({leftFirst ? right : left, depth + 1});
+        stack.push_back({leftFirst ? left : right, depth + 1});
     }
 
     return minDistance;
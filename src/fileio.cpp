@@ -27,7 +27,156 @@ std::vector<std::string> splitString(const std::string &str)
     return tokens;
 }
 
+namespace
+{
+    // Advances past the next line of the buffer, like std::getline
+    bool nextLine(std::string_view &rest, std::string_view &line)
+    {
+        if (rest.empty())
+            return false;
+        size_t end = rest.find('\n');
+        line = rest.substr(0, end);
+        rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+        return true;
+    }
+
+    // Same splitting as splitString, but the tokens are views into the line
+    void tokenizeLine(std::string_view line, std::vector<std::string_view> &tokens)
+    {
+        tokens.clear();
+        size_t i = 0;
+        while (i < line.size())
+        {
+            while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i])))
+                i++;
+            size_t begin = i;
+            while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i])))
+                i++;
+            if (i > begin)
+                tokens.push_back(line.substr(begin, i - begin));
+        }
+    }
+
+    // Parses the leading number of the token and throws if there is none, like std::stof/std::stoi
+    template <typename T>
+    T parseNumber(std::string_view token)
+    {
+        if (token.starts_with('+'))
+            token.remove_prefix(1);
+        T value{};
+        auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (ec != std::errc{})
+            throw std::runtime_error("Invalid number in mesh file: " + std::string{token} + "\n");
+        return value;
+    }
+
+    // safeStringToInt without the string: invalid, overlong or overflowing tokens become 0
+    int parseIndex(std::string_view token)
+    {
+        if (token.size() > std::to_string(std::numeric_limits<int>::max()).size())
+            return 0;
+        int value = 0;
+        auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (ec != std::errc{} || ptr != token.data() + token.size())
+            return 0;
+        return value;
+    }
+}
+
 GradMesh readHemeshFile(const std::string &filename)
+{
+    std::ifstream inf{filename, std::ios::binary | std::ios::ate};
+    if (!inf)
+    {
+        throw std::runtime_error("File could not be opened for reading\n");
+    }
+    std::string buffer(static_cast<size_t>(inf.tellg()), '\0');
+    inf.seekg(0);
+    inf.read(buffer.data(), buffer.size());
+
+    std::string_view rest{buffer};
+    std::string_view currLine;
+    std::vector<std::string_view> tokens;
+
+    nextLine(rest, currLine);
+    nextLine(rest, currLine);
+    tokenizeLine(currLine, tokens);
+
+    if (tokens.size() < 4)
+    {
+        throw std::runtime_error("Expected 4 tokens but got less than 4\n");
+    }
+    int numPoints = parseNumber<int>(tokens[0]);
+    int numHandles = parseNumber<int>(tokens[1]);
+    int numPatches = parseNumber<int>(tokens[2]);
+    int numEdges = parseNumber<int>(tokens[3]);
+
+    GradMesh gradMesh;
+    gradMesh.reserve(numPoints, numHandles, numPatches, numEdges);
+
+    for (int i = 0; i < numPoints && nextLine(rest, currLine); ++i)
+    {
+        tokenizeLine(currLine, tokens);
+        gradMesh.addPoint(parseNumber<float>(tokens[0]), parseNumber<float>(tokens[1]), parseNumber<int>(tokens[2]));
+    }
+    for (int i = 0; i < numHandles && nextLine(rest, currLine); ++i)
+    {
+        tokenizeLine(currLine, tokens);
+        gradMesh.addHandle(parseNumber<float>(tokens[1]), parseNumber<float>(tokens[2]), parseNumber<float>(tokens[3]),
+                           parseNumber<float>(tokens[4]), parseNumber<float>(tokens[5]), parseNumber<int>(tokens[0]));
+    }
+    for (int i = 0; i < numPatches && nextLine(rest, currLine); ++i)
+    {
+        tokenizeLine(currLine, tokens);
+        gradMesh.addFace(parseNumber<int>(tokens[0]));
+    }
+    std::vector<int> children;
+    for (int i = 0; i < numEdges && nextLine(rest, currLine); ++i)
+    {
+        tokenizeLine(currLine, tokens);
+
+        assert(tokens.size() >= 20);
+
+        HalfEdge halfEdge;
+        halfEdge.interval.x = parseNumber<float>(tokens[0]);
+        halfEdge.interval.y = parseNumber<float>(tokens[1]);
+        halfEdge.twist = {glm::vec2(parseNumber<float>(tokens[2]), parseNumber<float>(tokens[3])),
+                          glm::vec3(parseNumber<float>(tokens[4]), parseNumber<float>(tokens[5]), parseNumber<float>(tokens[6]))};
+        halfEdge.color = glm::vec3(parseNumber<float>(tokens[7]), parseNumber<float>(tokens[8]), parseNumber<float>(tokens[9]));
+        if (parseIndex(tokens[10]) >= 0)
+            halfEdge.handleIdxs = {parseIndex(tokens[10]), parseIndex(tokens[11])};
+        else
+            halfEdge.handleIdxs = {-1, -1};
+
+        int twinIdx = parseIndex(tokens[12]);
+        halfEdge.twinIdx = twinIdx >= 0 ? twinIdx : -1;
+        halfEdge.prevIdx = parseIndex(tokens[13]);
+        halfEdge.nextIdx = parseIndex(tokens[14]);
+        halfEdge.faceIdx = parseIndex(tokens[15]);
+        // token 16 is a placeholder
+        if (parseIndex(tokens[17]))
+        {
+            halfEdge.parentIdx = parseIndex(tokens[18]);
+            halfEdge.originIdx = -1;
+        }
+        else
+        {
+            halfEdge.parentIdx = -1;
+            halfEdge.originIdx = parseIndex(tokens[20]);
+        }
+
+        children.clear();
+        for (size_t t = 24; t < tokens.size(); ++t)
+            children.push_back(parseIndex(tokens[t]));
+        gradMesh.addEdge(halfEdge, children);
+    }
+    gradMesh.fixEdges();
+
+    return gradMesh;
+}
+
+// Previous reader, one stringstream per line and a std::string per token. Kept as the baseline for gms-cli bench-read.
+GradMesh readHemeshFileStream(const std::string &filename)
 {
     // std::cout << "Reading " << filename << std::endl;
     std::ifstream inf{filename};
@@ -121,14 +270,15 @@ GradMesh readHemeshFile(const std::string &filename)
                 halfEdge.originIdx = safeStringToInt(tokens[20]);
             }
 
+            std::vector<int> children;
             if (tokens.size() > 23)
             {
                 for (size_t i = 24; i < tokens.size(); ++i)
                 {
-                    halfEdge.childrenIdxs.push_back(safeStringToInt(tokens[i]));
+                    children.push_back(safeStringToInt(tokens[i]));
                 }
             }
-            gradMesh.addEdge(halfEdge);
+            gradMesh.addEdge(halfEdge, children);
         }
     }
     gradMesh.fixEdges();
@@ -199,7 +349,7 @@ void writeHemeshFile(const std::string &filename, const GradMesh &mesh)
             out << 0 << " " << 0 << " ";                                                  // 21, 22
         }
         out << 0 << " ";
-        for (int childIdx : halfEdge.childrenIdxs)
+        for (int childIdx : mesh.getChildren(halfEdge))
         {
             out << childIdx << " "; // 24 +
         }
@@ -209,6 +359,21 @@ void writeHemeshFile(const std::string &filename, const GradMesh &mesh)
     out.close();
 }
 
+GradMesh readMeshFile(const std::string &filename)
+{
+    if (isHemeshBinaryFile(filename))
+        return readHemeshBinaryFile(filename);
+    return readHemeshFile(filename);
+}
+
+void writeMeshFile(const std::string &filename, const GradMesh &mesh)
+{
+    if (isHemeshBinaryFile(filename))
+        writeHemeshBinaryFile(filename, mesh);
+    else
+        writeHemeshFile(filename, mesh);
+}
+
 void writeLogFile(const GradMesh &mesh, const std::string &filename)
 {
     std::ofstream debugLogFile(std::string{LOGS_DIR} + "/" + filename);
@@ -355,8 +520,23 @@ int safeStringToInt(const std::string &str)
     return static_cast<int>(number);
 }
 
-void saveConflictGraphToFile(const std::string &filename, const std::vector<TPRNode> &allTPRs, const std::vector<std::vector<int>> &adjList, const std::vector<EdgeRegion> &sortedRegions)
+void saveConflictGraphToFile(const std::string &filename, const std::vector<TPRNode> &allTPRs, const ConflictGraph &adjList, const std::vector<EdgeRegion> &sortedRegions)
 {
+    if (isConflictGraphBinaryFile(filename))
+    {
+        try
+        {
+            writeConflictGraphBinaryFile(filename, allTPRs, adjList, sortedRegions);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error writing " << filename << ": " << e.what();
+            return;
+        }
+        std::cout << "Data saved to " << filename << std::endl;
+        return;
+    }
+
     std::ofstream outFile(filename);
 
     if (!outFile)
@@ -379,8 +559,9 @@ void saveConflictGraphToFile(const std::string &filename, const std::vector<TPRN
 
     // Save adjList
     outFile << adjList.size() << "\n";
-    for (const auto &adj : adjList)
+    for (size_t i = 0; i < adjList.size(); i++)
     {
+        auto adj = adjList[i];
         outFile << adj.size();
         for (int node : adj)
         {
@@ -412,22 +593,37 @@ void saveConflictGraphToFile(const std::string &filename, const std::vector<TPRN
 
 // Load function to read from file
 
-void loadConflictGraphFromFile(const std::string &filename, std::vector<TPRNode> &allTPRs, std::vector<std::vector<int>> &adjList, std::vector<EdgeRegion> &sortedRegions)
+bool loadConflictGraphFromFile(const std::string &filename, std::vector<TPRNode> &allTPRs, ConflictGraph &adjList, std::vector<EdgeRegion> &sortedRegions)
 {
+    if (isConflictGraphBinaryFile(filename))
+    {
+        try
+        {
+            readConflictGraphBinaryFile(filename, allTPRs, adjList, sortedRegions);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error reading " << filename << ": " << e.what();
+            return false;
+        }
+        std::cout << "Data loaded from " << filename << std::endl;
+        return true;
+    }
+
     std::ifstream inFile(filename);
 
     if (!inFile)
     {
         std::cerr << "Error opening file for reading: " << filename << std::endl;
-        return;
+        return false;
     }
 
     // Load allTPRs
     size_t numTPRs;
     inFile >> numTPRs;
-    allTPRs.resize(numTPRs);
+    std::vector<TPRNode> fileTPRs(inFile ? numTPRs : 0);
 
-    for (auto &node : allTPRs)
+    for (auto &node : fileTPRs)
     {
         inFile >> node.id >> node.gridPair.first >> node.gridPair.second >> node.maxRegion.first >> node.maxRegion.second >> node.error >> node.maxChainLength >> node.degree;
     }
@@ -435,13 +631,13 @@ void loadConflictGraphFromFile(const std::string &filename, std::vector<TPRNode>
     // Load adjList
     size_t numAdjList;
     inFile >> numAdjList;
-    adjList.resize(numAdjList);
+    std::vector<std::vector<int>> adjLists(inFile ? numAdjList : 0);
 
-    for (auto &adj : adjList)
+    for (auto &adj : adjLists)
     {
         size_t numAdjNodes;
         inFile >> numAdjNodes;
-        adj.resize(numAdjNodes);
+        adj.resize(inFile ? numAdjNodes : 0);
 
         for (int &node : adj)
         {
@@ -452,15 +648,15 @@ void loadConflictGraphFromFile(const std::string &filename, std::vector<TPRNode>
     // Load sortedRegions
     size_t numSortedRegions;
     inFile >> numSortedRegions;
-    sortedRegions.resize(numSortedRegions);
+    std::vector<EdgeRegion> fileRegions(inFile ? numSortedRegions : 0);
 
-    for (auto &edgeRegion : sortedRegions)
+    for (auto &edgeRegion : fileRegions)
     {
         inFile >> edgeRegion.gridPair.first >> edgeRegion.gridPair.second >> edgeRegion.faceIdx;
 
         size_t numRegionAttributes;
         inFile >> numRegionAttributes;
-        edgeRegion.allRegionAttributes.resize(numRegionAttributes);
+        edgeRegion.allRegionAttributes.resize(inFile ? numRegionAttributes : 0);
 
         for (auto &region : edgeRegion.allRegionAttributes)
         {
@@ -470,6 +666,22 @@ void loadConflictGraphFromFile(const std::string &filename, std::vector<TPRNode>
         }
     }
 
-    inFile.close();
+    // the TPRs and their neighbours are used as indices
+    bool valid = inFile && adjLists.size() == fileTPRs.size();
+    for (const auto &node : fileTPRs)
+        valid = valid && node.id >= 0 && node.id < fileTPRs.size();
+    for (const auto &adj : adjLists)
+        for (int node : adj)
+            valid = valid && node >= 0 && node < fileTPRs.size();
+    if (!valid)
+    {
+        std::cerr << "Error reading " << filename << ": invalid conflict graph" << std::endl;
+        return false;
+    }
+
+    allTPRs = std::move(fileTPRs);
+    adjList = ConflictGraph{adjLists};
+    sortedRegions = std::move(fileRegions);
     std::cout << "Data loaded from " << filename << std::endl;
+    return true;
 }
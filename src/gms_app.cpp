@@ -4,6 +4,13 @@ int numTests = 6;
 
 GmsApp::GmsApp()
 {
+    // make sure to gen textures after intializing opengl
+    auto &resources = appState.patchRenderResources;
+    glGenTextures(1, &resources.unmergedTexture);
+    glGenTextures(1, &resources.mergedTexture);
+    glGenTextures(1, &resources.originalPreviewTexture);
+    glGenTextures(1, &resources.currentPreviewTexture);
+
     setupDirectories();
     setupNewMesh();
 }
@@ -11,7 +18,7 @@ GmsApp::GmsApp()
 void GmsApp::loadMesh()
 {
     appState.resetMerges();
-    appState.mesh = readHemeshFile(appState.filename);
+    appState.mesh = readMeshFile(appState.filename);
     appState.updateMeshRender();
     appState.setUnmergedGlPatches();
     merger.startupMesh();
@@ -22,6 +29,7 @@ void GmsApp::loadMesh()
 void GmsApp::setupNewMesh()
 {
     loadMesh();
+    appState.originalMesh = appState.mesh;
     createDir(SAVES_DIR);
     writeHemeshFile(DEFAULT_FIRST_SAVE_DIR, appState.mesh);
 }
@@ -32,8 +40,16 @@ void GmsApp::run()
     {
         glfwPollEvents();
 
-        if (appState.loadSave)
-            loadMesh();
+        if (appState.undoRequested)
+        {
+            merger.undoMerge();
+            appState.undoRequested = false;
+        }
+        if (appState.redoRequested)
+        {
+            merger.redoMerge();
+            appState.redoRequested = false;
+        }
 
         if (appState.filenameChanged)
             setupNewMesh();
@@ -80,6 +96,10 @@ void GmsApp::run()
         case MergeProcess::DualGridTest:
             runTest(DUAL_GRID);
             break;
+        case MergeProcess::CompareRenderBackends:
+            merger.metrics.compareRenderBackends(appState.patchRenderParams.glPatches);
+            appState.mergeProcess = MergeProcess::Merging;
+            break;
         case MergeProcess::Merging:
             merger.merge();
             break;
@@ -128,8 +148,7 @@ void GmsApp::runTest(MergeSelectMode mode)
         std::chrono::duration<double> elapsed = end - start;
         if (elapsed.count() > 0.1)
         {
-            merger.metrics.captureGlobalImage(appState.patchRenderParams.glPatches, CURR_IMG);
-            appState.mergeError = merger.metrics.evaluateMetric(CURR_IMG, ORIG_IMG);
+            appState.mergeError = merger.metrics.getGlobalError(appState.patchRenderParams.glPatches);
             std::vector<int> faceIdxs = getValidCompIndices(appState.mesh.getFaces());
             std::cout << randomTestCount << " " << faceIdxs.size() << " " << appState.mergeError << " " << elapsed.count() << std::endl;
             faceCounts.push_back(faceIdxs.size());
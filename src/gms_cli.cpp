@@ -0,0 +1,529 @@
+#include "fileio.hpp"
+#include "gms_appstate.hpp"
+#include "merging.hpp"
+#include "preprocessing.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Headless batch simplifier: loads a mesh, runs one merge strategy to completion and writes the result plus a JSON report.
+// Metrics are rendered with the CPU rasterizer, so no window or GL context is created.
+
+namespace
+{
+    enum class Strategy
+    {
+        Random,
+        Grid,
+        DualGrid,
+        Motorcycle,
+        Greedy,
+        GreedyOneStep
+    };
+
+    struct StrategyName
+    {
+        std::string_view name;
+        Strategy strategy;
+    };
+
+    inline constexpr StrategyName STRATEGY_NAMES[] = {
+        {"random", Strategy::Random},
+        {"grid", Strategy::Grid},
+        {"dual-grid", Strategy::DualGrid},
+        {"motorcycle", Strategy::Motorcycle},
+        {"greedy", Strategy::Greedy},
+        {"greedy-one-step", Strategy::GreedyOneStep},
+    };
+
+    struct CliOptions
+    {
+        std::string meshPath;
+        Strategy strategy = Strategy::Greedy;
+        std::string strategyName = "greedy";
+        float errorThreshold = ERROR_THRESHOLD;
+        MergeMetrics::MetricMode metricMode = MergeMetrics::SSIM;
+        int selectionIterations = -1; // keeps the app default
+        float selectionTime = -1.0f;  // keeps the app default
+        bool compareMetrics = false;
+        std::string outPath;
+        std::string reportPath;
+    };
+
+    struct CliReport
+    {
+        int facesBefore = 0;
+        int facesAfter = 0;
+        float error = 0.0f;
+        double seconds = 0.0;
+    };
+
+    void printUsage()
+    {
+        std::cerr << "usage: gms-cli <mesh.hemesh> [--strategy random|grid|dual-grid|motorcycle|greedy|greedy-one-step]\n"
+                  << "               [--threshold <error>] [--metric ssim|flip]\n"
+                  << "               [--selection-iterations <n>] [--selection-time <ms>]\n"
+                  << "               [--out <mesh.hemesh>] [--report <report.json>] [--compare-metrics]\n"
+                  << "       gms-cli convert [--verify] <mesh.hemesh|mesh.hemeshb>...\n"
+                  << "       gms-cli bench-read [--iterations <n>] <mesh.hemesh>...\n"
+                  << "       gms-cli bench-mesh [--iterations <n>] <mesh.hemesh>...\n";
+    }
+
+    std::optional<Strategy> parseStrategy(std::string_view name)
+    {
+        for (const auto &entry : STRATEGY_NAMES)
+            if (entry.name == name)
+                return entry.strategy;
+        return std::nullopt;
+    }
+
+    std::optional<CliOptions> parseArgs(int argc, char **argv)
+    {
+        CliOptions options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--strategy" && hasValue)
+            {
+                options.strategyName = argv[++i];
+                auto strategy = parseStrategy(options.strategyName);
+                if (!strategy)
+                {
+                    std::cerr << "Unknown strategy: " << options.strategyName << std::endl;
+                    return std::nullopt;
+                }
+                options.strategy = strategy.value();
+            }
+            else if (arg == "--threshold" && hasValue)
+            {
+                char *end = nullptr;
+                options.errorThreshold = std::strtof(argv[++i], &end);
+                if (*end != '\0' || options.errorThreshold < 0.0f)
+                {
+                    std::cerr << "Invalid error threshold: " << argv[i] << std::endl;
+                    return std::nullopt;
+                }
+            }
+            else if (arg == "--metric" && hasValue)
+            {
+                std::string_view metric = argv[++i];
+                if (metric == "ssim")
+                    options.metricMode = MergeMetrics::SSIM;
+                else if (metric == "flip")
+                    options.metricMode = MergeMetrics::FLIP;
+                else
+                {
+                    std::cerr << "Unknown metric: " << metric << std::endl;
+                    return std::nullopt;
+                }
+            }
+            else if (arg == "--selection-iterations" && hasValue)
+            {
+                char *end = nullptr;
+                long iterations = std::strtol(argv[++i], &end, 10);
+                if (*end != '\0' || iterations < 0 || iterations > std::numeric_limits<int>::max())
+                {
+                    std::cerr << "Invalid selection iterations: " << argv[i] << std::endl;
+                    return std::nullopt;
+                }
+                options.selectionIterations = iterations;
+            }
+            else if (arg == "--selection-time" && hasValue)
+            {
+                char *end = nullptr;
+                options.selectionTime = std::strtof(argv[++i], &end);
+                if (*end != '\0' || options.selectionTime < 0.0f)
+                {
+                    std::cerr << "Invalid selection time: " << argv[i] << std::endl;
+                    return std::nullopt;
+                }
+            }
+            else if (arg == "--compare-metrics")
+                options.compareMetrics = true;
+            else if (arg == "--out" && hasValue)
+                options.outPath = argv[++i];
+            else if (arg == "--report" && hasValue)
+                options.reportPath = argv[++i];
+            else if (!arg.starts_with("--") && options.meshPath.empty())
+                options.meshPath = arg;
+            else
+            {
+                std::cerr << "Unexpected argument: " << arg << std::endl;
+                return std::nullopt;
+            }
+        }
+
+        if (options.meshPath.empty())
+            return std::nullopt;
+
+        std::string meshname = extractFileName(options.meshPath);
+        if (options.outPath.empty())
+            options.outPath = meshname + "_simplified.hemesh";
+        if (options.reportPath.empty())
+            options.reportPath = meshname + "_report.json";
+        return options;
+    }
+
+    std::string jsonString(const std::string &str)
+    {
+        std::string out = "\"";
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    bool writeReport(const CliOptions &options, const CliReport &report)
+    {
+        std::ofstream outf{options.reportPath};
+        if (!outf)
+        {
+            std::cerr << "Could not open " << options.reportPath << " for writing" << std::endl;
+            return false;
+        }
+        outf << "{\n"
+             << "  \"input\": " << jsonString(options.meshPath) << ",\n"
+             << "  \"output\": " << jsonString(options.outPath) << ",\n"
+             << "  \"strategy\": " << jsonString(options.strategyName) << ",\n"
+             << "  \"metric\": " << jsonString(options.metricMode == MergeMetrics::SSIM ? "ssim" : "flip") << ",\n"
+             << "  \"threshold\": " << options.errorThreshold << ",\n"
+             << "  \"facesBefore\": " << report.facesBefore << ",\n"
+             << "  \"facesAfter\": " << report.facesAfter << ",\n"
+             << "  \"error\": " << report.error << ",\n"
+             << "  \"seconds\": " << report.seconds << "\n"
+             << "}\n";
+        return true;
+    }
+
+    // Mirrors GmsApp::setupNewMesh, the strategies roll back to appState.originalMesh
+    bool loadMesh(GmsAppState &appState, GradMeshMerger &merger, MergePreprocessor &preprocessor)
+    {
+        appState.resetMerges();
+        try
+        {
+            appState.mesh = readMeshFile(appState.filename);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Failed to read " << appState.filename << ": " << e.what();
+            return false;
+        }
+        appState.updateMeshRender();
+        appState.setUnmergedGlPatches();
+        merger.startupMesh();
+        appState.preprocessProductRegionsProgress = -1;
+        preprocessor.setEdgeRegions();
+        appState.originalMesh = appState.mesh;
+        return true;
+    }
+
+    // Drives the same step functions the frame loop calls until the strategy reports it is done
+    void runStrategy(Strategy strategy, GmsAppState &appState, GradMeshMerger &merger, MergePreprocessor &preprocessor)
+    {
+        switch (strategy)
+        {
+        case Strategy::Random:
+        case Strategy::Grid:
+        case Strategy::DualGrid:
+            appState.mergeMode = strategy == Strategy::Random ? RANDOM : (strategy == Strategy::Grid ? GRID : DUAL_GRID);
+            while (appState.mergeMode != NONE)
+                merger.merge();
+            break;
+        case Strategy::Motorcycle:
+            appState.preprocessSingleMergeProgress = 0;
+            while (appState.preprocessSingleMergeProgress != -2)
+                preprocessor.preprocessSingleMergeError();
+            preprocessor.mergeMotorcycle();
+            break;
+        case Strategy::Greedy:
+        case Strategy::GreedyOneStep:
+            if (appState.maxProductRegionsDone())
+                break;
+            while (appState.preprocessProductRegionsProgress != -2.0f)
+                preprocessor.preprocessProductRegions();
+            if (strategy == Strategy::Greedy)
+                preprocessor.mergeGreedyQuadError();
+            else
+                preprocessor.mergeGreedyQuadErrorOneStep();
+            break;
+        }
+    }
+
+    // Writes each mesh next to the input in the other format. Binary outputs are verified exactly, text outputs only by
+    // element counts since the text format rounds floats.
+    int runConvert(int argc, char **argv)
+    {
+        bool verify = false;
+        std::vector<std::string> inputs;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+            if (arg == "--verify")
+                verify = true;
+            else if (arg.starts_with("--"))
+            {
+                std::cerr << "Unexpected argument: " << arg << std::endl;
+                return 1;
+            }
+            else
+                inputs.emplace_back(arg);
+        }
+        if (inputs.empty())
+        {
+            printUsage();
+            return 1;
+        }
+
+        int failures = 0;
+        for (const auto &input : inputs)
+        {
+            std::string output = std::filesystem::path{input}.replace_extension(isHemeshBinaryFile(input) ? ".hemesh" : HEMESHB_EXTENSION).string();
+            try
+            {
+                GradMesh mesh = readMeshFile(input);
+                writeMeshFile(output, mesh);
+                if (verify)
+                {
+                    GradMesh written = readMeshFile(output);
+                    bool same = isHemeshBinaryFile(output)
+                                    ? written.sameAs(mesh)
+                                    : written.getPoints().size() == mesh.getPoints().size() && written.getHandles().size() == mesh.getHandles().size() &&
+                                          written.getFaces().size() == mesh.getFaces().size() && written.getEdges().size() == mesh.getEdges().size();
+                    if (!same)
+                    {
+                        std::cerr << output << " does not match " << input << std::endl;
+                        failures++;
+                        continue;
+                    }
+                }
+                std::cout << input << " -> " << output << (verify ? " (verified)" : "") << std::endl;
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Failed to convert " << input << ": " << e.what();
+                failures++;
+            }
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    // Average milliseconds per read over the given number of iterations
+    template <typename Reader>
+    double timeReader(Reader reader, const std::string &filename, int iterations, GradMesh &mesh)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++)
+            mesh = reader(filename);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+    // Compares the stringstream based text reader with the from_chars one and checks that they build the same mesh
+    int runBenchRead(int argc, char **argv)
+    {
+        int iterations = 20;
+        std::vector<std::string> inputs;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+            if (arg == "--iterations" && i + 1 < argc)
+            {
+                iterations = std::atoi(argv[++i]);
+                if (iterations <= 0)
+                {
+                    std::cerr << "Invalid iteration count: " << argv[i] << std::endl;
+                    return 1;
+                }
+            }
+            else if (arg.starts_with("--"))
+            {
+                std::cerr << "Unexpected argument: " << arg << std::endl;
+                return 1;
+            }
+            else
+                inputs.emplace_back(arg);
+        }
+        if (inputs.empty())
+        {
+            printUsage();
+            return 1;
+        }
+
+        int failures = 0;
+        for (const auto &input : inputs)
+        {
+            try
+            {
+                GradMesh streamMesh, mesh;
+                double streamMs = timeReader(readHemeshFileStream, input, iterations, streamMesh);
+                double ms = timeReader(readHemeshFile, input, iterations, mesh);
+                bool same = mesh.sameAs(streamMesh);
+                failures += !same;
+                std::cout << input << ": stream " << streamMs << " ms, from_chars " << ms << " ms, "
+                          << streamMs / ms << "x" << (same ? "" : ", MESHES DIFFER") << std::endl;
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Failed to read " << input << ": " << e.what();
+                failures++;
+            }
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    // Walks every face ring and the twin, parent and child links of its edges, the access pattern of the merge code
+    long long traverseTopology(const GradMesh &mesh)
+    {
+        long long checksum = 0;
+        const auto &edges = mesh.getEdges();
+        for (const auto &face : mesh.getFaces())
+        {
+            if (!face.isValid())
+                continue;
+            for (int edgeIdx : mesh.getFaceEdgeIdxs(face.halfEdgeIdx))
+            {
+                const auto &edge = edges[edgeIdx];
+                checksum += edge.twinIdx + edge.nextIdx + edge.prevIdx + edge.parentIdx;
+                if (edge.hasTwin())
+                    checksum += edges[edge.twinIdx].faceIdx;
+                for (int childIdx : mesh.getChildren(edgeIdx))
+                    checksum += edges[childIdx].originIdx;
+            }
+        }
+        return checksum;
+    }
+
+    // Times copying a mesh (what the candidate search and the sweeps do per worker) and walking its topology
+    int runBenchMesh(int argc, char **argv)
+    {
+        int iterations = 200;
+        std::vector<std::string> inputs;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+            if (arg == "--iterations" && i + 1 < argc)
+            {
+                iterations = std::atoi(argv[++i]);
+                if (iterations <= 0)
+                {
+                    std::cerr << "Invalid iteration count: " << argv[i] << std::endl;
+                    return 1;
+                }
+            }
+            else if (arg.starts_with("--"))
+            {
+                std::cerr << "Unexpected argument: " << arg << std::endl;
+                return 1;
+            }
+            else
+                inputs.emplace_back(arg);
+        }
+        if (inputs.empty())
+        {
+            printUsage();
+            return 1;
+        }
+
+        int failures = 0;
+        for (const auto &input : inputs)
+        {
+            try
+            {
+                GradMesh mesh = readMeshFile(input);
+                auto start = std::chrono::high_resolution_clock::now();
+                size_t copiedEdges = 0;
+                for (int i = 0; i < iterations; i++)
+                {
+                    GradMesh copy = mesh;
+                    copiedEdges += copy.getEdges().size();
+                }
+                std::chrono::duration<double, std::milli> copyElapsed = std::chrono::high_resolution_clock::now() - start;
+
+                start = std::chrono::high_resolution_clock::now();
+                long long checksum = 0;
+                for (int i = 0; i < iterations; i++)
+                    checksum += traverseTopology(mesh);
+                std::chrono::duration<double, std::milli> traverseElapsed = std::chrono::high_resolution_clock::now() - start;
+
+                std::cout << input << ": " << mesh.getEdges().size() << " edges, copy " << copyElapsed.count() / iterations
+                          << " ms, traversal " << traverseElapsed.count() / iterations << " ms (checksum " << checksum / iterations
+                          << ", " << copiedEdges / iterations << " edges copied)" << std::endl;
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Failed to read " << input << ": " << e.what();
+                failures++;
+            }
+        }
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && std::string_view{argv[1]} == "convert")
+        return runConvert(argc - 1, argv + 1);
+    if (argc > 1 && std::string_view{argv[1]} == "bench-read")
+        return runBenchRead(argc - 1, argv + 1);
+    if (argc > 1 && std::string_view{argv[1]} == "bench-mesh")
+        return runBenchMesh(argc - 1, argv + 1);
+
+    auto options = parseArgs(argc, argv);
+    if (!options)
+    {
+        printUsage();
+        return 1;
+    }
+
+    GmsAppState appState{};
+    GradMeshMerger merger{appState};
+    MergePreprocessor preprocessor{merger, appState};
+
+    appState.filename = options->meshPath;
+    appState.writeMeshSaves = false;
+    appState.mergeSettings.renderBackend = MergeMetrics::CPU;
+    appState.mergeSettings.metricMode = options->metricMode;
+    appState.mergeSettings.errorThreshold = options->errorThreshold;
+    if (options->selectionIterations >= 0)
+        appState.independentSetIterations = options->selectionIterations;
+    if (options->selectionTime >= 0.0f)
+        appState.independentSetTime = options->selectionTime;
+
+    setupDirectories();
+    if (!loadMesh(appState, merger, preprocessor))
+        return 1;
+
+    CliReport report;
+    report.facesBefore = getValidCompIndices(appState.mesh.getFaces()).size();
+    auto start = std::chrono::high_resolution_clock::now();
+
+    runStrategy(options->strategy, appState, merger, preprocessor);
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    report.seconds = elapsed.count();
+    appState.updateMeshRender();
+    report.error = merger.metrics.getGlobalError(appState.patchRenderParams.glPatches);
+    report.facesAfter = getValidCompIndices(appState.mesh.getFaces()).size();
+    if (options->compareMetrics)
+        merger.metrics.compareSSIMEngines(appState.patchRenderParams.glPatches);
+
+    writeMeshFile(options->outPath, appState.mesh);
+    if (!writeReport(*options, report))
+        return 1;
+
+    std::cout << options->strategyName << ": " << report.facesBefore << " -> " << report.facesAfter
+              << " faces, error " << report.error << ", " << report.seconds << "s" << std::endl;
+    return 0;
+}
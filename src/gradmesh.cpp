@@ -2,37 +2,33 @@
 
 std::optional<std::vector<Patch>> GradMesh::generatePatches() const
 {
-    std::vector<Patch> patches{};
-
-    for (int faceIdx = 0; faceIdx < faces.size(); faceIdx++)
-    {
-        const auto &face = faces[faceIdx];
-        if (!face.isValid())
-            continue;
-
-        auto [e0, e1, e2, e3] = getFaceEdgeIdxs(face.halfEdgeIdx);
-        auto topEdgeDerivatives = computeEdgeDerivatives(edges[e0]);
-        auto rightEdgeDerivatives = computeEdgeDerivatives(edges[e1]);
-        auto bottomEdgeDerivatives = computeEdgeDerivatives(edges[e2]);
-        auto leftEdgeDerivatives = computeEdgeDerivatives(edges[e3]);
+    if (!patchCache.update(*this))
+        return std::nullopt;
+    return patchCache.getPatches();
+}
 
-        if (!topEdgeDerivatives || !rightEdgeDerivatives || !bottomEdgeDerivatives || !leftEdgeDerivatives)
-            return std::nullopt;
+std::optional<Patch> GradMesh::generatePatch(int faceIdx) const
+{
+    auto [e0, e1, e2, e3] = getFaceEdgeIdxs(faces[faceIdx].halfEdgeIdx);
+    auto topEdgeDerivatives = computeEdgeDerivatives(edges[e0]);
+    auto rightEdgeDerivatives = computeEdgeDerivatives(edges[e1]);
+    auto bottomEdgeDerivatives = computeEdgeDerivatives(edges[e2]);
+    auto leftEdgeDerivatives = computeEdgeDerivatives(edges[e3]);
 
-        auto [m0, m0v, m1v, m0uv] = topEdgeDerivatives.value();
-        auto [m1, m1u, m3u, m1uv] = rightEdgeDerivatives.value();
-        auto [m3, m3v, m2v, m3uv] = bottomEdgeDerivatives.value();
-        auto [m2, m2u, m0u, m2uv] = leftEdgeDerivatives.value();
+    if (!topEdgeDerivatives || !rightEdgeDerivatives || !bottomEdgeDerivatives || !leftEdgeDerivatives)
+        return std::nullopt;
 
-        std::vector<Vertex> controlMatrix = {m0, m0v, m1v, m1,       //
-                                             -m0u, m0uv, -m1uv, m1u, //
-                                             -m2u, -m2uv, m3uv, m3u, //
-                                             m2, -m2v, -m3v, m3};
+    auto [m0, m0v, m1v, m0uv] = topEdgeDerivatives.value();
+    auto [m1, m1u, m3u, m1uv] = rightEdgeDerivatives.value();
+    auto [m3, m3v, m2v, m3uv] = bottomEdgeDerivatives.value();
+    auto [m2, m2u, m0u, m2uv] = leftEdgeDerivatives.value();
 
-        patches.push_back(Patch{controlMatrix, faceIdx, {e0, e1, e2, e3}});
-    }
+    std::vector<Vertex> controlMatrix = {m0, m0v, m1v, m1,       //
+                                         -m0u, m0uv, -m1uv, m1u, //
+                                         -m2u, -m2uv, m3uv, m3u, //
+                                         m2, -m2v, -m3v, m3};
 
-    return patches;
+    return Patch{controlMatrix, faceIdx, {e0, e1, e2, e3}};
 }
 
 EdgeDerivatives GradMesh::getCurve(int halfEdgeIdx, int depth) const
@@ -184,6 +180,153 @@ void GradMesh::fixEdges()
     // std::cout << "There are " << count << " weird edges.\n";
 }
 
+void GradMesh::beginTransaction()
+{
+    journal.openIds.push_back(journal.newId());
+    journal.points.begin(points);
+    journal.handles.begin(handles);
+    journal.faces.begin(faces);
+    journal.edges.begin(edges);
+    journal.childArenaSizes.push_back(childArena.size());
+}
+
+void GradMesh::commit(bool keepForUndo)
+{
+    if (journal.openIds.empty())
+    {
+        std::cerr << "No mesh transaction to commit" << std::endl;
+        return;
+    }
+    journal.openIds.pop_back();
+    journal.childArenaSizes.pop_back();
+    journal.points.commit(keepForUndo);
+    journal.handles.commit(keepForUndo);
+    journal.faces.commit(keepForUndo);
+    journal.edges.commit(keepForUndo);
+}
+
+void GradMesh::rollback(int n)
+{
+    for (int i = 0; i < n && !journal.openIds.empty(); i++)
+    {
+        markTouched(journal.edges.open.back(), journal.handles.open.back(), journal.faces.open.back());
+        journal.openIds.pop_back();
+        journal.points.rollback(points);
+        journal.handles.rollback(handles);
+        journal.faces.rollback(faces);
+        journal.edges.rollback(edges);
+        // child lists are never edited in place, the slices written since the transaction began are unreferenced now
+        childArena.resize(journal.childArenaSizes.back());
+        journal.childArenaSizes.pop_back();
+    }
+}
+
+bool GradMesh::undo()
+{
+    if (!canUndo())
+        return false;
+    markTouched(journal.edges.history.back(), journal.handles.history.back(), journal.faces.history.back());
+    journal.points.undo(points);
+    journal.handles.undo(handles);
+    journal.faces.undo(faces);
+    journal.edges.undo(edges);
+    return true;
+}
+
+bool GradMesh::redo()
+{
+    if (!canRedo())
+        return false;
+    unsigned id = journal.newId();
+    journal.points.redo(points, id);
+    journal.handles.redo(handles, id);
+    journal.faces.redo(faces, id);
+    journal.edges.redo(edges, id);
+    markTouched(journal.edges.history.back(), journal.handles.history.back(), journal.faces.history.back());
+    return true;
+}
+
+void GradMesh::markTouched(const ElementJournal<HalfEdge>::Mark &edgeMark, const ElementJournal<Handle>::Mark &handleMark,
+                           const ElementJournal<Face>::Mark &faceMark)
+{
+    journal.edges.forEachTouched(edgeMark, edges.size(), [this](int idx)
+                                 {
+                                     patchCache.markEdge(idx);
+                                     changedEdges.mark(idx); });
+    journal.handles.forEachTouched(handleMark, handles.size(), [this](int idx)
+                                   { patchCache.markHandle(idx); });
+    journal.faces.forEachTouched(faceMark, faces.size(), [this](int idx)
+                                 { patchCache.markFace(idx); });
+}
+
+void GradMesh::clearJournal()
+{
+    journal.openIds.clear();
+    journal.childArenaSizes.clear();
+    journal.points.clear();
+    journal.handles.clear();
+    journal.faces.clear();
+    journal.edges.clear();
+}
+
+bool GradMesh::sameAs(const GradMesh &other) const
+{
+    auto samePoint = [](const Point &a, const Point &b)
+    { return a.coords == b.coords && a.halfEdgeIdx == b.halfEdgeIdx; };
+    auto sameHandle = [](const Handle &a, const Handle &b)
+    { return a.coords == b.coords && a.color == b.color && a.halfEdgeIdx == b.halfEdgeIdx; };
+    auto sameFace = [](const Face &a, const Face &b)
+    { return a.halfEdgeIdx == b.halfEdgeIdx; };
+    auto sameEdge = [&](const HalfEdge &a, const HalfEdge &b)
+    {
+        return a.interval == b.interval && a.twist.coords == b.twist.coords && a.twist.color == b.twist.color &&
+               a.color == b.color && a.handleIdxs == b.handleIdxs && a.twinIdx == b.twinIdx && a.prevIdx == b.prevIdx &&
+               a.nextIdx == b.nextIdx && a.faceIdx == b.faceIdx && a.originIdx == b.originIdx && a.parentIdx == b.parentIdx &&
+               std::ranges::equal(getChildren(a), other.getChildren(b)) && a.childIdxDegenerate == b.childIdxDegenerate;
+    };
+    return std::ranges::equal(points, other.points, samePoint) && std::ranges::equal(handles, other.handles, sameHandle) &&
+           std::ranges::equal(faces, other.faces, sameFace) && std::ranges::equal(edges, other.edges, sameEdge);
+}
+
+void GradMesh::setChildren(int edgeIdx, std::span<const int> children)
+{
+    // the span may point into the arena, which can reallocate while appending
+    std::vector<int> list(children.begin(), children.end());
+    editEdge(edgeIdx).children = {static_cast<int>(childArena.size()), static_cast<int>(list.size())};
+    childArena.insert(childArena.end(), list.begin(), list.end());
+}
+
+void GradMesh::addChildren(int edgeIdx, std::span<const int> newChildren)
+{
+    auto current = getChildren(edgeIdx);
+    std::vector<int> list(current.begin(), current.end());
+    for (int child : newChildren)
+        if (std::find(list.begin(), list.end(), child) == list.end())
+            list.push_back(child);
+    if (list.size() != current.size())
+        setChildren(edgeIdx, list);
+}
+
+void GradMesh::replaceChild(int edgeIdx, int oldChildIdx, int newChildIdx)
+{
+    auto current = getChildren(edgeIdx);
+    if (std::find(current.begin(), current.end(), oldChildIdx) == current.end())
+        return;
+    std::vector<int> list(current.begin(), current.end());
+    std::replace(list.begin(), list.end(), oldChildIdx, newChildIdx);
+    setChildren(edgeIdx, list);
+}
+
+void GradMesh::removeChild(int edgeIdx, int childIdx)
+{
+    auto current = getChildren(edgeIdx);
+    if (std::find(current.begin(), current.end(), childIdx) == current.end())
+        return;
+    std::vector<int> list(current.begin(), current.end());
+    list.erase(std::remove(list.begin(), list.end(), childIdx), list.end());
+    setChildren(edgeIdx, list);
+}
+
 std::array<int, 4> GradMesh::getFaceEdgeIdxs(int edgeIdx) const
 {
     std::array<int, 4> edgeIdxs;
@@ -311,29 +454,13 @@ void GradMesh::findULPoints()
         if (!edge.hasTwin())
             ++pointMap[edge.originIdx].second;
     }
+    ulPoints.resize(points.size(), 0);
     for (const auto &point : pointMap)
     {
         auto pair = point.second;
-        if (pair.first > 2 && pair.second > 0)
-            ulPointIdxs.push_back(point.first);
-    }
-}
-
-bool GradMesh::isULMergeEdge(const HalfEdge &edge) const
-{
-    if (std::ranges::find(ulPointIdxs, edge.originIdx) != ulPointIdxs.end())
-    {
-        return true;
-    }
-    if (edge.hasTwin())
-    {
-        const auto &twinEdge = edges[edge.twinIdx];
-        if (std::ranges::find(ulPointIdxs, twinEdge.originIdx) != ulPointIdxs.end())
-        {
-            return true;
-        }
+        if (pair.first > 2 && pair.second > 0 && point.first >= 0)
+            ulPoints[point.first] = 1;
     }
-    return false;
 }
 
 std::vector<std::pair<int, int>> GradMesh::getGridEdgeIdxs(int rowIdx, int colIdx) const
@@ -427,14 +554,6 @@ std::vector<int> GradMesh::getIncidentFacesOfRegion(const Region &region) const
     return faceIdxs;
 }
 
-bool GradMesh::regionsOverlap(const Region &region1, const Region &region2) const
-{
-    auto faces1 = getIncidentFacesOfRegion(region1);
-    auto faces2 = getIncidentFacesOfRegion(region2);
-    return std::ranges::any_of(faces1, [&faces2](int val)
-                               { return std::ranges::find(faces2, val) != faces2.end(); });
-}
-
 int GradMesh::maxDependencyChain() const
 {
     int maxChain = 0;
@@ -51,12 +51,14 @@ void renderComparisonWindow(const GmsAppState &appState)
                 ImGui::TableHeadersRow();
                 ImGui::TableNextRow(ImGuiTableRowFlags_None, GUI_FINAL_IMAGE_SIZE + 10);
                 ImGui::TableSetColumnIndex(0);
-                GLuint texture = LoadTextureFromFile(ORIG_IMG);
+                GLuint texture = appState.patchRenderResources.originalPreviewTexture;
+                uploadImageToTexture(appState.metricImages.original.view(), texture);
                 auto [w, h] = appState.mergeSettings.globalPaddedAABB.getRes(GUI_FINAL_IMAGE_SIZE);
                 ImGui::Image((ImTextureID)texture, ImVec2(w, h));
 
                 ImGui::TableSetColumnIndex(1);
-                GLuint texture2 = LoadTextureFromFile(CURR_IMG);
+                GLuint texture2 = appState.patchRenderResources.currentPreviewTexture;
+                uploadImageToTexture(appState.metricImages.current.view(), texture2);
                 ImGui::Image((ImTextureID)texture2, ImVec2(w, h));
                 ImGui::EndTable();
             }
@@ -402,7 +404,7 @@ void GmsGui::showWindowMenuBar()
     ImGui::SetNextWindowSize(ImVec2(GL_LENGTH, 20));
 
     fileDialog.SetTitle("title");
-    fileDialog.SetTypeFilters({".hemesh"});
+    fileDialog.SetTypeFilters({".hemesh", ".hemeshb"});
 
     ImGui::Begin("Gradient mesh renderer", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_MenuBar);
 
@@ -550,6 +552,8 @@ void showDifferentMergingMethods(GmsAppState &appState)
         else
             ImGui::ProgressBar(appState.preprocessProductRegionsProgress, ImVec2(-1.0f, 0.0f));
         ImGui::Spacing();
+        if (ImGui::Button("Cancel"))
+            appState.cancelRequested = true;
         return;
     }
     switch (edge_select_current)
@@ -635,10 +639,12 @@ void showDifferentMergingMethods(GmsAppState &appState)
                 ImGui::TableHeadersRow();
                 ImGui::TableNextRow(ImGuiTableRowFlags_None, GUI_PREVIEW_IMAGE_SIZE + 10);
                 ImGui::TableSetColumnIndex(0);
-                GLuint texture = LoadTextureFromFile(ORIG_IMG);
+                GLuint texture = appState.patchRenderResources.originalPreviewTexture;
+                uploadImageToTexture(appState.metricImages.original.view(), texture);
                 ImGui::Image((ImTextureID)texture, ImVec2(GUI_PREVIEW_IMAGE_SIZE, GUI_PREVIEW_IMAGE_SIZE));
                 ImGui::TableSetColumnIndex(1);
-                GLuint texture2 = LoadTextureFromFile(CURR_IMG);
+                GLuint texture2 = appState.patchRenderResources.currentPreviewTexture;
+                uploadImageToTexture(appState.metricImages.current.view(), texture2);
                 ImGui::Image((ImTextureID)texture2, ImVec2(GUI_PREVIEW_IMAGE_SIZE, GUI_PREVIEW_IMAGE_SIZE));
 
                 ImGui::EndTable();
@@ -860,6 +866,11 @@ void showMergingMenu(GmsAppState &appState)
             {
                 appState.mergeSettings.metricMode = static_cast<MergeMetrics::MetricMode>(item_current);
             }
+            static int item_backend = static_cast<int>(appState.mergeSettings.renderBackend);
+            if (ImGui::Combo("Render backend", &item_backend, render_backend_items, IM_ARRAYSIZE(render_backend_items)))
+            {
+                appState.mergeSettings.renderBackend = static_cast<MergeMetrics::RenderBackend>(item_backend);
+            }
             static int item_image_region = static_cast<int>(appState.mergeSettings.pixelRegion);
             const char *image_region_items[] = {"Global", "Local"};
             /*
@@ -880,9 +891,13 @@ void showMergingMenu(GmsAppState &appState)
                     appState.quadErrorWeight = 1.0f - complementWeight;
                 }
                 ImGui::PopItemWidth();
+                ImGui::DragInt("Selection iterations", &appState.independentSetIterations, 10.0f, 0, 1000000);
+                ImGui::DragFloat("Selection time (ms)", &appState.independentSetTime, 1.0f, 0.0f, 10000.0f, "%.0f");
             }
             ImGui::DragFloat("Error threshold", &appState.mergeSettings.errorThreshold, 0.0001f, 0.0001f, 0.1f, "%.4f");
             ImGui::DragInt("Pooling resolution", &appState.mergeSettings.poolRes, 1.0f, 100, 1000);
+            ImGui::Checkbox("Write metric images to disk", &appState.mergeSettings.writeDebugImages);
+            ImGui::Checkbox("Native SSIM", &appState.mergeSettings.nativeSSIM);
             // ImGui::DragFloat("AABB padding", &appState.mergeSettings.aabbPadding, 0.01f, 0.0f, 0.1f);
             ImGui::PopItemWidth();
 
@@ -1041,18 +1056,21 @@ void showMergingMenu(GmsAppState &appState)
         ImGui::Spacing();
         ImGui::Separator();
         ImGui::Spacing();
+        ImGui::Checkbox("Write mesh saves", &appState.writeMeshSaves);
         if (ImGui::Button("Reset mesh"))
         {
             appState.filenameChanged = true;
         }
         ImGui::SameLine();
-        if (ImGui::Button(ICON_FA_ARROW_ROTATE_LEFT) && appState.currentSave != 0)
-        {
-            appState.loadSave = true;
-            appState.filename = "mesh_saves/save_" + std::to_string(--appState.currentSave) + ".hemesh";
-        }
+        ImGui::BeginDisabled(!appState.mesh.canUndo());
+        if (ImGui::Button(ICON_FA_ARROW_ROTATE_LEFT))
+            appState.undoRequested = true;
+        ImGui::EndDisabled();
         ImGui::SameLine();
-        ImGui::Button(ICON_FA_ARROW_ROTATE_RIGHT);
+        ImGui::BeginDisabled(!appState.mesh.canRedo());
+        if (ImGui::Button(ICON_FA_ARROW_ROTATE_RIGHT))
+            appState.redoRequested = true;
+        ImGui::EndDisabled();
 
         ImGui::Spacing();
     }
@@ -1090,6 +1108,10 @@ void showTestingMenu(GmsAppState &appState)
             appState.mergeMode = NONE;
             appState.mergeProcess = MergeProcess::DualGridTest;
         }
+        if (ImGui::Button("Compare render backends"))
+        {
+            appState.mergeProcess = MergeProcess::CompareRenderBackends;
+        }
         ImGui::EndDisabled();
         ImGui::Spacing();
     }
@@ -1244,7 +1266,7 @@ void showGradMeshInfo(GmsAppState &appState)
             bool selectedFaceChanged = createListBox(items, selectedFaceIdx, item_highlighted_idx);
             if (selectedFaceChanged && selectedFaceIdx != appState.patches[appState.userSelectedId.patchId].getFaceIdx())
             {
-                appState.setPatchId(getPatchFromFaceIdx(appState.patches, selectedFaceIdx));
+                appState.setPatchId(appState.patchLookup.patchOfFace(selectedFaceIdx));
             }
             ImGui::Spacing();
             ImGui::Text("%d faces", faceIdxs.size());
@@ -1286,19 +1308,19 @@ void showGradMeshInfo(GmsAppState &appState)
             {
                 appState.setUserCurveColor(black);
                 int prevPatch = userId.patchId;
-                appState.userSelectedId = getCurveIdFromEdgeIdx(appState.patches, edgeIdxs[selectedHalfEdgeIdx]);
+                appState.userSelectedId = appState.patchLookup.curveOfEdge(edgeIdxs[selectedHalfEdgeIdx]);
                 appState.setUserCurveColor(blue);
                 appState.updateCurves({prevPatch, appState.userSelectedId.patchId});
             }
             else if (selectedEdgeChanged)
             {
-                appState.userSelectedId = getCurveIdFromEdgeIdx(appState.patches, edgeIdxs[selectedHalfEdgeIdx]);
+                appState.userSelectedId = appState.patchLookup.curveOfEdge(edgeIdxs[selectedHalfEdgeIdx]);
             }
             ImGui::Spacing();
             ImGui::Text("%d edges", edgeIdxs.size());
             ImGui::NextColumn();
             if (selectedHalfEdgeIdx != -1)
-                setHalfEdgeInfo(halfedges, selectedHalfEdgeIdx, edgeIdxs);
+                setHalfEdgeInfo(appState.mesh, selectedHalfEdgeIdx, edgeIdxs);
 
             ImGui::Columns(1);
 
@@ -1376,11 +1398,11 @@ void setFaceInfo(const auto &components, int &item_selected_idx, const auto &idx
     ImGui::Spacing();
 }
 
-void setHalfEdgeInfo(const auto &components, int &item_selected_idx, const auto &idxs)
+void setHalfEdgeInfo(const GradMesh &mesh, int &item_selected_idx, const auto &idxs)
 {
     // if (item_selected_idx >= idxs.size())
     // item_selected_idx = idxs.size() - 1;
-    auto &selectedEdge = components[idxs[item_selected_idx]];
+    auto &selectedEdge = mesh.getEdges()[idxs[item_selected_idx]];
 
     ImGui::Spacing();
     ImGui::Text(" e%d", idxs[item_selected_idx]);
@@ -1516,14 +1538,15 @@ void setHalfEdgeInfo(const auto &components, int &item_selected_idx, const auto
             ImGui::Text("Children");
             ImGui::TableSetColumnIndex(1);
             pushColor(ButtonColor::Children);
-            for (size_t i = 0; i < selectedEdge.childrenIdxs.size(); ++i)
+            auto children = mesh.getChildren(selectedEdge);
+            for (size_t i = 0; i < children.size(); ++i)
             {
                 if (i % 3 == 0 && i != 0)
                 {
                     ImGui::Text("");
                 }
                 ImGui::SameLine();
-                compButton(item_selected_idx, idxs, selectedEdge.childrenIdxs[i], "e");
+                compButton(item_selected_idx, idxs, children[i], "e");
             }
             ImGui::PopStyleColor(3);
         }
@@ -0,0 +1,126 @@
+#include "hemesh_binary.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+bool isHemeshBinaryFile(const std::string &filename)
+{
+    return filename.ends_with(HEMESHB_EXTENSION);
+}
+
+GradMesh readHemeshBinaryFile(const std::string &filename)
+{
+    MappedFile file{filename};
+    size_t offset = 0;
+
+    auto header = readRecords<hemeshb::Header>(file, offset, 1)[0];
+    if (std::memcmp(header.magic, HEMESHB_MAGIC, sizeof(HEMESHB_MAGIC)) != 0)
+        throw std::runtime_error("Not a binary mesh file\n");
+    if (header.version != HEMESHB_VERSION)
+        throw std::runtime_error("Unsupported binary mesh version " + std::to_string(header.version) + "\n");
+
+    auto points = readRecords<hemeshb::PointRecord>(file, offset, header.numPoints);
+    auto handles = readRecords<hemeshb::HandleRecord>(file, offset, header.numHandles);
+    auto faces = readRecords<hemeshb::FaceRecord>(file, offset, header.numFaces);
+    auto edges = readRecords<hemeshb::EdgeRecord>(file, offset, header.numEdges);
+    auto children = readRecords<int32_t>(file, offset, header.numChildren);
+
+    GradMesh gradMesh;
+    gradMesh.reserve(points.size(), handles.size(), faces.size(), edges.size());
+    gradMesh.reserveChildren(children.size());
+    for (const auto &p : points)
+        gradMesh.addPoint(p.coords[0], p.coords[1], p.halfEdgeIdx);
+    for (const auto &h : handles)
+        gradMesh.addHandle(h.coords[0], h.coords[1], h.color[0], h.color[1], h.color[2], h.halfEdgeIdx);
+    for (const auto &f : faces)
+        gradMesh.addFace(f.halfEdgeIdx);
+    for (const auto &e : edges)
+    {
+        if (static_cast<size_t>(e.firstChild) + e.numChildren > children.size())
+            throw std::runtime_error("Binary mesh file has an invalid child range\n");
+
+        HalfEdge halfEdge;
+        halfEdge.interval = {e.interval[0], e.interval[1]};
+        halfEdge.twist = {glm::vec2(e.twistCoords[0], e.twistCoords[1]), glm::vec3(e.twistColor[0], e.twistColor[1], e.twistColor[2])};
+        halfEdge.color = glm::vec3(e.color[0], e.color[1], e.color[2]);
+        halfEdge.handleIdxs = {e.handleIdxs[0], e.handleIdxs[1]};
+        halfEdge.twinIdx = e.twinIdx;
+        halfEdge.prevIdx = e.prevIdx;
+        halfEdge.nextIdx = e.nextIdx;
+        halfEdge.faceIdx = e.faceIdx;
+        halfEdge.originIdx = e.originIdx;
+        halfEdge.parentIdx = e.parentIdx;
+        halfEdge.childIdxDegenerate = e.childIdxDegenerate;
+        gradMesh.addEdge(halfEdge, std::span<const int>{children.data() + e.firstChild, e.numChildren});
+    }
+    return gradMesh;
+}
+
+void writeHemeshBinaryFile(const std::string &filename, const GradMesh &mesh)
+{
+    std::ofstream out{filename, std::ios::binary};
+    if (!out)
+    {
+        throw std::runtime_error("File could not be opened for writing\n");
+    }
+
+    std::vector<hemeshb::PointRecord> points;
+    points.reserve(mesh.getPoints().size());
+    for (const auto &p : mesh.getPoints())
+        points.push_back({{p.coords.x, p.coords.y}, p.halfEdgeIdx});
+
+    std::vector<hemeshb::HandleRecord> handles;
+    handles.reserve(mesh.getHandles().size());
+    for (const auto &h : mesh.getHandles())
+        handles.push_back({{h.coords.x, h.coords.y}, {h.color.r, h.color.g, h.color.b}, h.halfEdgeIdx});
+
+    std::vector<hemeshb::FaceRecord> faces;
+    faces.reserve(mesh.getFaces().size());
+    for (const auto &f : mesh.getFaces())
+        faces.push_back({f.halfEdgeIdx});
+
+    std::vector<hemeshb::EdgeRecord> edges;
+    std::vector<int32_t> children;
+    edges.reserve(mesh.getEdges().size());
+    for (const auto &e : mesh.getEdges())
+    {
+        edges.push_back({{e.interval.x, e.interval.y},
+                         {e.twist.coords.x, e.twist.coords.y},
+                         {e.twist.color.r, e.twist.color.g, e.twist.color.b},
+                         {e.color.r, e.color.g, e.color.b},
+                         {e.handleIdxs.first, e.handleIdxs.second},
+                         e.twinIdx,
+                         e.prevIdx,
+                         e.nextIdx,
+                         e.faceIdx,
+                         e.originIdx,
+                         e.parentIdx,
+                         e.childIdxDegenerate,
+                         static_cast<uint32_t>(children.size()),
+                         static_cast<uint32_t>(e.children.count)});
+        auto edgeChildren = mesh.getChildren(e);
+        children.insert(children.end(), edgeChildren.begin(), edgeChildren.end());
+    }
+
+    hemeshb::Header header{};
+    std::memcpy(header.magic, HEMESHB_MAGIC, sizeof(HEMESHB_MAGIC));
+    header.version = HEMESHB_VERSION;
+    header.numPoints = points.size();
+    header.numHandles = handles.size();
+    header.numFaces = faces.size();
+    header.numEdges = edges.size();
+    header.numChildren = children.size();
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeRecords(out, points);
+    writeRecords(out, handles);
+    writeRecords(out, faces);
+    writeRecords(out, edges);
+    writeRecords(out, children);
+    if (!out)
+        throw std::runtime_error("Could not write " + filename + "\n");
+}
@@ -0,0 +1,430 @@
+#include "incremental_ssim.hpp"
+#include "metric_context.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if !defined(GMS_SSIM_NO_AVX2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GMS_SSIM_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    inline constexpr int WINDOW_SIZE{2 * SSIM_WINDOW_RADIUS + 1};
+    inline constexpr float SSIM_C1{(0.01f * 255.0f) * (0.01f * 255.0f)};
+    inline constexpr float SSIM_C2{(0.03f * 255.0f) * (0.03f * 255.0f)};
+
+    const std::array<float, WINDOW_SIZE> &gaussianWindow()
+    {
+        static const std::array<float, WINDOW_SIZE> window = []
+        {
+            std::array<float, WINDOW_SIZE> w;
+            float sum = 0.0f;
+            for (int i = 0; i < WINDOW_SIZE; i++)
+            {
+                float d = static_cast<float>(i - SSIM_WINDOW_RADIUS);
+                w[i] = std::exp(-d * d / (2.0f * SSIM_WINDOW_SIGMA * SSIM_WINDOW_SIGMA));
+                sum += w[i];
+            }
+            for (float &v : w)
+                v /= sum;
+            return w;
+        }();
+        return window;
+    }
+
+    // One tile of window positions [mx0, mx1) x [my0, my1), position (mx, my) covers the pixels
+    // [mx, mx + WINDOW_SIZE) x [my, my + WINDOW_SIZE). Rows are interleaved channels, so a horizontal tap is a step of
+    // `channels` elements and every channel of the tile is filtered in the same pass. The SSIM of every position is
+    // also written to ssimMap when one is given, interleaved like the reference statistics.
+    struct TileInput
+    {
+        const uint8_t *image;
+        const uint8_t *reference;
+        const float *refMean;
+        const float *refVariance;
+        int width;
+        int channels;
+        int mapWidth;
+        int mx0, mx1, my0, my1;
+        float *ssimMap;
+    };
+
+    // Horizontal pass of E[x], E[x^2] and E[xy] over every pixel row the tile's windows touch
+    void horizontalMomentsScalar(const TileInput &in, float *hMean, float *hSquare, float *hCross)
+    {
+        const auto &w = gaussianWindow();
+        const int numElements = (in.mx1 - in.mx0) * in.channels;
+        const int rows = in.my1 - in.my0 + WINDOW_SIZE - 1;
+        for (int r = 0; r < rows; r++)
+        {
+            const size_t rowStart = (static_cast<size_t>(in.my0 + r) * in.width + in.mx0) * in.channels;
+            const uint8_t *x = in.image + rowStart;
+            const uint8_t *y = in.reference + rowStart;
+            for (int e = 0; e < numElements; e++)
+            {
+                float sumX = 0.0f, sumXX = 0.0f, sumXY = 0.0f;
+                for (int k = 0; k < WINDOW_SIZE; k++)
+                {
+                    const float vx = x[e + k * in.channels];
+                    const float vy = y[e + k * in.channels];
+                    sumX += w[k] * vx;
+                    sumXX += w[k] * vx * vx;
+                    sumXY += w[k] * vx * vy;
+                }
+                const size_t h = static_cast<size_t>(r) * numElements + e;
+                hMean[h] = sumX;
+                hSquare[h] = sumXX;
+                hCross[h] = sumXY;
+            }
+        }
+    }
+
+    float ssimFromMoments(float muX, float squareX, float crossXY, float muY, float varY)
+    {
+        const float varX = squareX - muX * muX;
+        const float covXY = crossXY - muX * muY;
+        return ((2.0f * muX * muY + SSIM_C1) * (2.0f * covXY + SSIM_C2)) /
+               ((muX * muX + muY * muY + SSIM_C1) * (varX + varY + SSIM_C2));
+    }
+
+    double ssimTileScalar(const TileInput &in, AlignedVector<float> &scratch)
+    {
+        const auto &w = gaussianWindow();
+        const int numElements = (in.mx1 - in.mx0) * in.channels;
+        const size_t planeSize = static_cast<size_t>(in.my1 - in.my0 + WINDOW_SIZE - 1) * numElements;
+        scratch.resize(3 * planeSize);
+        float *hMean = scratch.data(), *hSquare = hMean + planeSize, *hCross = hSquare + planeSize;
+        horizontalMomentsScalar(in, hMean, hSquare, hCross);
+
+        double sum = 0.0;
+        for (int y = 0; y < in.my1 - in.my0; y++)
+        {
+            const size_t m = (static_cast<size_t>(in.my0 + y) * in.mapWidth + in.mx0) * in.channels;
+            for (int e = 0; e < numElements; e++)
+            {
+                float muX = 0.0f, squareX = 0.0f, crossXY = 0.0f;
+                for (int k = 0; k < WINDOW_SIZE; k++)
+                {
+                    const size_t h = static_cast<size_t>(y + k) * numElements + e;
+                    muX += w[k] * hMean[h];
+                    squareX += w[k] * hSquare[h];
+                    crossXY += w[k] * hCross[h];
+                }
+                const float ssim = ssimFromMoments(muX, squareX, crossXY, in.refMean[m + e], in.refVariance[m + e]);
+                if (in.ssimMap)
+                    in.ssimMap[m + e] = ssim;
+                sum += ssim;
+            }
+        }
+        return sum;
+    }
+
+#ifdef GMS_SSIM_AVX2
+    __attribute__((target("avx2,fma"))) inline __m256 loadPixels8(const uint8_t *p)
+    {
+        return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+    }
+
+    // Same passes as ssimTileScalar, eight interleaved channel values at a time, the row tails fall back to scalar code
+    __attribute__((target("avx2,fma"))) double ssimTileAVX2(const TileInput &in, AlignedVector<float> &scratch)
+    {
+        const auto &w = gaussianWindow();
+        const int numElements = (in.mx1 - in.mx0) * in.channels;
+        const int vecElements = numElements / 8 * 8;
+        const int rows = in.my1 - in.my0 + WINDOW_SIZE - 1;
+        const size_t planeSize = static_cast<size_t>(rows) * numElements;
+        scratch.resize(3 * planeSize);
+        float *hMean = scratch.data(), *hSquare = hMean + planeSize, *hCross = hSquare + planeSize;
+
+        for (int r = 0; r < rows; r++)
+        {
+            const size_t rowStart = (static_cast<size_t>(in.my0 + r) * in.width + in.mx0) * in.channels;
+            const uint8_t *x = in.image + rowStart;
+            const uint8_t *y = in.reference + rowStart;
+            float *outMean = hMean + static_cast<size_t>(r) * numElements;
+            float *outSquare = hSquare + static_cast<size_t>(r) * numElements;
+            float *outCross = hCross + static_cast<size_t>(r) * numElements;
+            int e = 0;
+            for (; e < vecElements; e += 8)
+            {
+                __m256 sumX = _mm256_setzero_ps(), sumXX = _mm256_setzero_ps(), sumXY = _mm256_setzero_ps();
+                for (int k = 0; k < WINDOW_SIZE; k++)
+                {
+                    const __m256 wk = _mm256_set1_ps(w[k]);
+                    const __m256 vx = loadPixels8(x + e + k * in.channels);
+                    const __m256 vy = loadPixels8(y + e + k * in.channels);
+                    const __m256 wx = _mm256_mul_ps(wk, vx);
+                    sumX = _mm256_add_ps(sumX, wx);
+                    sumXX = _mm256_fmadd_ps(wx, vx, sumXX);
+                    sumXY = _mm256_fmadd_ps(wx, vy, sumXY);
+                }
+                _mm256_storeu_ps(outMean + e, sumX);
+                _mm256_storeu_ps(outSquare + e, sumXX);
+                _mm256_storeu_ps(outCross + e, sumXY);
+            }
+            for (; e < numElements; e++)
+            {
+                float sumX = 0.0f, sumXX = 0.0f, sumXY = 0.0f;
+                for (int k = 0; k < WINDOW_SIZE; k++)
+                {
+                    const float vx = x[e + k * in.channels];
+                    const float vy = y[e + k * in.channels];
+                    sumX += w[k] * vx;
+                    sumXX += w[k] * vx * vx;
+                    sumXY += w[k] * vx * vy;
+                }
+                outMean[e] = sumX;
+                outSquare[e] = sumXX;
+                outCross[e] = sumXY;
+            }
+        }
+
+        const __m256 c1 = _mm256_set1_ps(SSIM_C1);
+        const __m256 c2 = _mm256_set1_ps(SSIM_C2);
+        const __m256 two = _mm256_set1_ps(2.0f);
+        __m256d accLow = _mm256_setzero_pd(), accHigh = _mm256_setzero_pd();
+        double tailSum = 0.0;
+        for (int y = 0; y < in.my1 - in.my0; y++)
+        {
+            const size_t m = (static_cast<size_t>(in.my0 + y) * in.mapWidth + in.mx0) * in.channels;
+            int e = 0;
+            for (; e < vecElements; e += 8)
+            {
+                __m256 muX = _mm256_setzero_ps(), squareX = _mm256_setzero_ps(), crossXY = _mm256_setzero_ps();
+                for (int k = 0; k < WINDOW_SIZE; k++)
+                {
+                    const __m256 wk = _mm256_set1_ps(w[k]);
+                    const size_t h = static_cast<size_t>(y + k) * numElements + e;
+                    muX = _mm256_fmadd_ps(wk, _mm256_loadu_ps(hMean + h), muX);
+                    squareX = _mm256_fmadd_ps(wk, _mm256_loadu_ps(hSquare + h), squareX);
+                    crossXY = _mm256_fmadd_ps(wk, _mm256_loadu_ps(hCross + h), crossXY);
+                }
+                const __m256 muY = _mm256_loadu_ps(in.refMean + m + e);
+                const __m256 varY = _mm256_loadu_ps(in.refVariance + m + e);
+                const __m256 varX = _mm256_fnmadd_ps(muX, muX, squareX);
+                const __m256 covXY = _mm256_fnmadd_ps(muX, muY, crossXY);
+                const __m256 muXY = _mm256_mul_ps(muX, muY);
+                const __m256 numerator = _mm256_mul_ps(_mm256_fmadd_ps(two, muXY, c1), _mm256_fmadd_ps(two, covXY, c2));
+                const __m256 muSquares = _mm256_fmadd_ps(muX, muX, _mm256_mul_ps(muY, muY));
+                const __m256 denominator = _mm256_mul_ps(_mm256_add_ps(muSquares, c1), _mm256_add_ps(_mm256_add_ps(varX, varY), c2));
+                const __m256 ssim = _mm256_div_ps(numerator, denominator);
+                if (in.ssimMap)
+                    _mm256_storeu_ps(in.ssimMap + m + e, ssim);
+                accLow = _mm256_add_pd(accLow, _mm256_cvtps_pd(_mm256_castps256_ps128(ssim)));
+                accHigh = _mm256_add_pd(accHigh, _mm256_cvtps_pd(_mm256_extractf128_ps(ssim, 1)));
+            }
+            for (; e < numElements; e++)
+            {
+                float muX = 0.0f, squareX = 0.0f, crossXY = 0.0f;
+                for (int k = 0; k < WINDOW_SIZE; k++)
+                {
+                    const size_t h = static_cast<size_t>(y + k) * numElements + e;
+                    muX += w[k] * hMean[h];
+                    squareX += w[k] * hSquare[h];
+                    crossXY += w[k] * hCross[h];
+                }
+                const float ssim = ssimFromMoments(muX, squareX, crossXY, in.refMean[m + e], in.refVariance[m + e]);
+                if (in.ssimMap)
+                    in.ssimMap[m + e] = ssim;
+                tailSum += ssim;
+            }
+        }
+
+        alignas(32) double lanes[8];
+        _mm256_store_pd(lanes, accLow);
+        _mm256_store_pd(lanes + 4, accHigh);
+        double sum = tailSum;
+        for (double lane : lanes)
+            sum += lane;
+        return sum;
+    }
+
+    bool cpuHasAVX2()
+    {
+        static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        return supported;
+    }
+#endif
+
+    double ssimTile(const TileInput &in)
+    {
+        thread_local AlignedVector<float> scratch;
+#ifdef GMS_SSIM_AVX2
+        if (cpuHasAVX2())
+            return ssimTileAVX2(in, scratch);
+#endif
+        return ssimTileScalar(in, scratch);
+    }
+}
+
+SSIMReference::SSIMReference(const ImageView &ref)
+    : width(ref.width), height(ref.height), numChannels(ref.channels),
+      mapW(std::max(0, ref.width - WINDOW_SIZE + 1)), mapH(std::max(0, ref.height - WINDOW_SIZE + 1)),
+      tilesX((mapW + SSIM_TILE_SIZE - 1) / SSIM_TILE_SIZE), tilesY((mapH + SSIM_TILE_SIZE - 1) / SSIM_TILE_SIZE),
+      pixels(ref.data, ref.data + ref.size())
+{
+    // a window against itself gives E[y] and E[y^2], computed once per reference
+    const size_t mapSize = static_cast<size_t>(mapW) * mapH * numChannels;
+    mean.resize(mapSize);
+    variance.resize(mapSize);
+    const auto &w = gaussianWindow();
+#pragma omp parallel for schedule(dynamic)
+    for (int tileIdx = 0; tileIdx < numTiles(); tileIdx++)
+    {
+        auto [mx0, mx1, my0, my1] = tileRect(tileIdx);
+        TileInput in{pixels.data(), pixels.data(), nullptr, nullptr, width, numChannels, mapW, mx0, mx1, my0, my1, nullptr};
+        const int numElements = (mx1 - mx0) * numChannels;
+        const size_t planeSize = static_cast<size_t>(my1 - my0 + WINDOW_SIZE - 1) * numElements;
+        std::vector<float> hMean(planeSize), hSquare(planeSize), hCross(planeSize);
+        horizontalMomentsScalar(in, hMean.data(), hSquare.data(), hCross.data());
+        for (int y = 0; y < my1 - my0; y++)
+        {
+            const size_t m = (static_cast<size_t>(my0 + y) * mapW + mx0) * numChannels;
+            for (int e = 0; e < numElements; e++)
+            {
+                float muY = 0.0f, squareY = 0.0f;
+                for (int k = 0; k < WINDOW_SIZE; k++)
+                {
+                    const size_t h = static_cast<size_t>(y + k) * numElements + e;
+                    muY += w[k] * hMean[h];
+                    squareY += w[k] * hSquare[h];
+                }
+                mean[m + e] = muY;
+                variance[m + e] = squareY - muY * muY;
+            }
+        }
+    }
+}
+
+bool SSIMReference::sameShape(const ImageView &image) const
+{
+    return !image.empty() && image.width == width && image.height == height && image.channels == numChannels;
+}
+
+bool SSIMReference::matches(const ImageView &image) const
+{
+    return sameShape(image) && std::memcmp(image.data, pixels.data(), pixels.size()) == 0;
+}
+
+SSIMReference::TileRect SSIMReference::tileRect(int tileIdx) const
+{
+    const int mx0 = (tileIdx % tilesX) * SSIM_TILE_SIZE;
+    const int my0 = (tileIdx / tilesX) * SSIM_TILE_SIZE;
+    return {mx0, std::min(mapW, mx0 + SSIM_TILE_SIZE), my0, std::min(mapH, my0 + SSIM_TILE_SIZE)};
+}
+
+double SSIMReference::tileSum(const ImageView &image, int tileIdx, float *ssimMap) const
+{
+    auto [mx0, mx1, my0, my1] = tileRect(tileIdx);
+    TileInput in{image.data, pixels.data(), mean.data(), variance.data(), width, numChannels, mapW, mx0, mx1, my0, my1, ssimMap};
+    return ssimTile(in);
+}
+
+float SSIMReference::meanFromTileSums(const std::vector<double> &tileSums) const
+{
+    double total = 0.0;
+    for (double tileSum : tileSums)
+        total += tileSum;
+    return static_cast<float>(total / (static_cast<double>(mapW) * mapH * numChannels));
+}
+
+float SSIMReference::score(const ImageView &image, float *ssimMap) const
+{
+    if (!sameShape(image))
+    {
+        fprintf(stderr, "Images must have the same dimensions and number of channels\n");
+        return -1;
+    }
+    if (numTiles() == 0)
+        return 1.0f;
+    std::vector<double> tileSums(numTiles());
+    for (int tileIdx = 0; tileIdx < numTiles(); tileIdx++)
+        tileSums[tileIdx] = tileSum(image, tileIdx, ssimMap);
+    return meanFromTileSums(tileSums);
+}
+
+void IncrementalSSIM::setReference(std::shared_ptr<const SSIMReference> newReference)
+{
+    reference = std::move(newReference);
+    tileSums.assign(reference ? reference->numTiles() : 0, 0.0);
+    tileDirty.assign(tileSums.size(), 0);
+    base.clear();
+}
+
+float IncrementalSSIM::score(const ImageView &image)
+{
+    if (!reference || !reference->sameShape(image))
+    {
+        fprintf(stderr, "Images must have the same dimensions and number of channels\n");
+        return -1;
+    }
+    if (reference->numTiles() == 0)
+        return 1.0f;
+
+    markDirtyTiles(image);
+    numDirtyTiles = static_cast<int>(dirtyTileIdxs.size());
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numDirtyTiles; i++)
+        tileSums[dirtyTileIdxs[i]] = reference->tileSum(image, dirtyTileIdxs[i]);
+    for (int tileIdx : dirtyTileIdxs)
+        tileDirty[tileIdx] = 0;
+    base.assign(image.data, image.data + image.size());
+    return reference->meanFromTileSums(tileSums);
+}
+
+// A pixel changed since the base image is seen by the windows up to WINDOW_SIZE - 1 positions before it
+void IncrementalSSIM::markDirtyTiles(const ImageView &image)
+{
+    dirtyTileIdxs.clear();
+    auto markTile = [&](int tileIdx)
+    {
+        if (!tileDirty[tileIdx])
+        {
+            tileDirty[tileIdx] = 1;
+            dirtyTileIdxs.push_back(tileIdx);
+        }
+    };
+
+    if (base.size() != image.size())
+    {
+        for (int tileIdx = 0; tileIdx < reference->numTiles(); tileIdx++)
+            markTile(tileIdx);
+        return;
+    }
+
+    const int channels = reference->channels();
+    const int mapWidth = reference->mapWidth();
+    const int mapHeight = reference->mapHeight();
+    const size_t rowBytes = static_cast<size_t>(image.width) * channels;
+    for (int py = 0; py < image.height; py++)
+    {
+        const uint8_t *row = image.data + py * rowBytes;
+        const uint8_t *baseRow = base.data() + py * rowBytes;
+        if (std::memcmp(row, baseRow, rowBytes) == 0)
+            continue;
+
+        size_t first = 0;
+        while (row[first] == baseRow[first])
+            first++;
+        size_t last = rowBytes - 1;
+        while (row[last] == baseRow[last])
+            last--;
+        const int px0 = static_cast<int>(first / channels);
+        const int px1 = static_cast<int>(last / channels);
+
+        const int mx0 = std::max(0, px0 - WINDOW_SIZE + 1);
+        const int mx1 = std::min(mapWidth - 1, px1);
+        const int my0 = std::max(0, py - WINDOW_SIZE + 1);
+        const int my1 = std::min(mapHeight - 1, py);
+        if (mx0 > mx1 || my0 > my1)
+            continue;
+        for (int ty = my0 / SSIM_TILE_SIZE; ty <= my1 / SSIM_TILE_SIZE; ty++)
+            for (int tx = mx0 / SSIM_TILE_SIZE; tx <= mx1 / SSIM_TILE_SIZE; tx++)
+                markTile(ty * reference->tilesX + tx);
+    }
+}
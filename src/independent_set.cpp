@@ -0,0 +1,241 @@
+#include "independent_set.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // gains below this are rounding noise of the running weight
+    constexpr double MIN_GAIN = 1e-9;
+    constexpr int PERTURB_ATTEMPTS = 32;
+}
+
+IndependentSetSolver::IndependentSetSolver(const ConflictGraph &graph, std::vector<float> weights, std::vector<float> costs, float capacity, unsigned seed)
+    : graph{graph}, weights{std::move(weights)}, costs{std::move(costs)}, capacity{capacity}, gen{seed}, queued{graph.size()}, marks(graph.size(), 0)
+{
+    setSolution({});
+}
+
+void IndependentSetSolver::setSolution(std::span<const int> vertices)
+{
+    const size_t n = graph.size();
+    inSet.resize(n);
+    tightness.assign(n, 0);
+    solutionSlot.assign(n, -1);
+    solution.clear();
+    weight = 0.0;
+    cost = 0.0;
+    for (int v : vertices)
+        setMember(v, true);
+    journal.clear();
+    bestSolution = solution;
+    bestWeight = weight;
+}
+
+int IndependentSetSolver::improve(std::chrono::duration<double> budget, int maxIterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (graph.size() == 0)
+        return 0;
+
+    // the set only changes where local search finds a gain, anything worse is undone
+    auto accept = [this]()
+    {
+        if (weight + MIN_GAIN >= bestWeight)
+        {
+            bestSolution = solution;
+            bestWeight = weight;
+            journal.clear();
+        }
+        else
+        {
+            undo(0);
+        }
+    };
+
+    for (size_t v = 0; v < graph.size(); v++)
+        push(v);
+    localSearch();
+    accept();
+
+    int iterations = 0;
+    while (iterations < maxIterations && std::chrono::steady_clock::now() - start < budget)
+    {
+        perturb();
+        localSearch();
+        accept();
+        iterations++;
+    }
+    return iterations;
+}
+
+std::vector<int> IndependentSetSolver::getBestSet() const
+{
+    auto best = bestSolution;
+    std::ranges::sort(best);
+    return best;
+}
+
+void IndependentSetSolver::setMember(int v, bool member)
+{
+    if (member)
+    {
+        inSet.set(v);
+        solutionSlot[v] = solution.size();
+        solution.push_back(v);
+    }
+    else
+    {
+        int last = solution.back();
+        solution[solutionSlot[v]] = last;
+        solutionSlot[last] = solutionSlot[v];
+        solution.pop_back();
+        solutionSlot[v] = -1;
+        inSet.reset(v);
+    }
+    int sign = member ? 1 : -1;
+    weight += sign * weights[v];
+    cost += sign * costs[v];
+    for (int neighbour : graph[v])
+        tightness[neighbour] += sign;
+}
+
+void IndependentSetSolver::insert(int v)
+{
+    setMember(v, true);
+    for (int neighbour : graph[v])
+        push(neighbour);
+    journal.push_back({v, true});
+}
+
+void IndependentSetSolver::remove(int v)
+{
+    setMember(v, false);
+    for (int neighbour : graph[v])
+        push(neighbour);
+    push(v);
+    journal.push_back({v, false});
+}
+
+void IndependentSetSolver::push(int v)
+{
+    if (queued.test(v))
+        return;
+    queued.set(v);
+    worklist.push_back(v);
+}
+
+// Replays the journal backwards, it runs between local searches when nothing is queued
+void IndependentSetSolver::undo(size_t journalSize)
+{
+    while (journal.size() > journalSize)
+    {
+        auto [v, inserted] = journal.back();
+        setMember(v, !inserted);
+        journal.pop_back();
+    }
+}
+
+// (k,1)-swap: v joins the set and its neighbours in the set leave it
+bool IndependentSetSolver::trySwapIn(int v)
+{
+    if (weights[v] <= 0.0f || costs[v] >= capacity)
+        return false;
+    double lostWeight = 0.0;
+    double freedCost = 0.0;
+    for (int neighbour : graph[v])
+    {
+        if (inSet.test(neighbour))
+        {
+            lostWeight += weights[neighbour];
+            freedCost += costs[neighbour];
+        }
+    }
+    if (weights[v] - lostWeight <= MIN_GAIN || !fits(costs[v] - freedCost))
+        return false;
+
+    for (int neighbour : graph[v])
+        if (inSet.test(neighbour))
+            remove(neighbour);
+    insert(v);
+    return true;
+}
+
+// (1,2)-swap: v and the best other neighbour of its only set neighbour u replace u
+bool IndependentSetSolver::tryTwoForOne(int v)
+{
+    if (tightness[v] != 1 || weights[v] <= 0.0f)
+        return false;
+    int u = -1;
+    ++markStamp;
+    for (int neighbour : graph[v])
+    {
+        marks[neighbour] = markStamp;
+        if (inSet.test(neighbour))
+            u = neighbour;
+    }
+    if (u == -1)
+        return false;
+
+    double baseGain = static_cast<double>(weights[v]) - weights[u];
+    double baseCost = static_cast<double>(costs[v]) - costs[u];
+    int bestPartner = -1;
+    double bestGain = MIN_GAIN;
+    for (int y : graph[u])
+    {
+        if (y == v || tightness[y] != 1 || marks[y] == markStamp)
+            continue;
+        double gain = baseGain + weights[y];
+        if (gain > bestGain && fits(baseCost + costs[y]))
+        {
+            bestPartner = y;
+            bestGain = gain;
+        }
+    }
+    if (bestPartner == -1)
+        return false;
+
+    remove(u);
+    insert(v);
+    insert(bestPartner);
+    return true;
+}
+
+void IndependentSetSolver::localSearch()
+{
+    while (!worklist.empty())
+    {
+        int v = worklist.back();
+        worklist.pop_back();
+        queued.reset(v);
+        if (inSet.test(v))
+            continue;
+        if (!trySwapIn(v))
+            tryTwoForOne(v);
+    }
+}
+
+// Forces one, now and then a few, random vertices into the set, dropping whatever conflicts or exceeds the capacity
+void IndependentSetSolver::perturb()
+{
+    std::uniform_int_distribution<int> vertexDistrib(0, graph.size() - 1);
+    int numForced = gen() % 8 == 0 ? 2 + gen() % 3 : 1;
+    for (int i = 0; i < numForced; i++)
+    {
+        int v = -1;
+        for (int attempt = 0; attempt < PERTURB_ATTEMPTS && v == -1; attempt++)
+        {
+            int candidate = vertexDistrib(gen);
+            if (!inSet.test(candidate) && weights[candidate] > 0.0f && costs[candidate] < capacity)
+                v = candidate;
+        }
+        if (v == -1)
+            return;
+
+        for (int neighbour : graph[v])
+            if (inSet.test(neighbour))
+                remove(neighbour);
+        while (!fits(costs[v]) && !solution.empty())
+            remove(solution[gen() % solution.size()]);
+        insert(v);
+    }
+}
@@ -0,0 +1,52 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &filename)
+{
+#ifdef _WIN32
+    std::ifstream inf{filename, std::ios::binary};
+    if (!inf)
+        throw std::runtime_error("File could not be opened for reading\n");
+    buffer.assign(std::istreambuf_iterator<char>(inf), std::istreambuf_iterator<char>());
+    bytes = buffer.data();
+    size = buffer.size();
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error("File could not be opened for reading\n");
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        close(fd);
+        throw std::runtime_error("File could not be opened for reading\n");
+    }
+    size = static_cast<size_t>(st.st_size);
+    if (size > 0)
+    {
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("File could not be mapped\n");
+        }
+        bytes = static_cast<const char *>(mapped);
+    }
+    close(fd);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+    if (bytes)
+        munmap(const_cast<char *>(bytes), size);
+#endif
+}
@@ -5,34 +5,72 @@
 MergeMetrics::MergeMetrics(Params params)
     : mesh(params.mesh),
       mergeSettings(params.mergeSettings),
-      patchRenderResources(params.patchRenderResources)
+      patchRenderResources(params.patchRenderResources),
+      images(params.images)
 {
-    glGenFramebuffers(1, &unmergedFbo);
-    glGenFramebuffers(1, &mergedFbo);
+}
+
+GLuint MergeMetrics::getFramebuffer(bool mergedTarget)
+{
+    GLuint &fbo = mergedTarget ? mergedFbo : unmergedFbo;
+    if (fbo == 0)
+        glGenFramebuffers(1, &fbo);
+    return fbo;
+}
+
+void MergeMetrics::renderPatches(const std::vector<GLfloat> &glPatches, const AABB &aabb, std::pair<int, int> res, bool mergedTarget, Image &image,
+                                 PatchVertexBuffer *buffer)
+{
+    if (mergeSettings.renderBackend == RenderBackend::CPU)
+    {
+        rasterizePatches(glPatches, aabb, res.first, res.second, image);
+        return;
+    }
+
+    FBtoImgParams params = {
+        .texture = mergedTarget ? patchRenderResources.mergedTexture : patchRenderResources.unmergedTexture,
+        .fbo = getFramebuffer(mergedTarget),
+        .width = res.first,
+        .height = res.second,
+        .image = image,
+        .glPatches = glPatches,
+        .shaderId = patchRenderResources.patchShaderId,
+        .aabb = aabb,
+        .patchBuffer = buffer};
+
+    FBtoImg(params);
 }
 
 void MergeMetrics::markTwoHalfEdges(int idx1, int idx2)
 {
-    auto &lookup = lookupValenceVertex[idx1];
+    auto lookup = valenceSlot(idx1);
     valenceVertices[lookup.first].setMarked(lookup.second);
-    auto &lookup2 = lookupValenceVertex[idx2];
+    auto lookup2 = valenceSlot(idx2);
     valenceVertices[lookup2.first].setMarked(lookup2.second);
 }
 
 void MergeMetrics::unmarkTwoHalfEdges(int idx1, int idx2)
 {
-    auto &lookup = lookupValenceVertex[idx1];
+    auto lookup = valenceSlot(idx1);
     valenceVertices[lookup.first].unmark(lookup.second);
-    auto &lookup2 = lookupValenceVertex[idx2];
+    auto lookup2 = valenceSlot(idx2);
     valenceVertices[lookup2.first].unmark(lookup2.second);
 }
 
 bool MergeMetrics::isMarked(int halfEdgeIdx)
 {
-    auto &lookup = lookupValenceVertex[halfEdgeIdx];
+    auto lookup = valenceSlot(halfEdgeIdx);
     return valenceVertices[lookup.first].markedEdges[lookup.second] == 1;
 }
 
+// Edges that stem from no valence vertex land on the first slot of vertex 0
+std::pair<int, int> MergeMetrics::valenceSlot(int halfEdgeIdx) const
+{
+    if (halfEdgeIdx < 0 || static_cast<size_t>(halfEdgeIdx) >= lookupValenceVertex.size())
+        return {0, 0};
+    return lookupValenceVertex[halfEdgeIdx];
+}
+
 void MergeMetrics::findSumOfErrors(MergeableRegion &mr)
 {
     auto [rowIdx, colIdx] = mr.gridPair;
@@ -201,7 +239,7 @@ void MergeMetrics::generateMotorcycleGraph()
             int valenceTwoL = v.halfEdgeIdxs[valenceTwoLIdx];
             while (true)
             {
-                int newDheIdx = findDoubleHalfEdgeIndex(edgeErrors, valenceTwoL);
+                int newDheIdx = edgeErrorIdxs[valenceTwoL];
                 assert(newDheIdx != -1);
                 auto newDhe = edgeErrors[newDheIdx]; // get double half edge of L grower
 
@@ -228,7 +266,7 @@ void MergeMetrics::generateMotorcycleGraph()
             valenceTwoL = v.halfEdgeIdxs[valenceTwoLIdx2];
             while (true)
             {
-                int newDheIdx = findDoubleHalfEdgeIndex(edgeErrors, valenceTwoL);
+                int newDheIdx = edgeErrorIdxs[valenceTwoL];
                 assert(newDheIdx != -1);
                 auto newDhe = edgeErrors[newDheIdx]; // get double half edge of L grower
 
@@ -277,7 +315,7 @@ void MergeMetrics::generateMotorcycleGraph()
         int valenceOne = v.halfEdgeIdxs[valenceOneIdx];
         while (true)
         {
-            int newDheIdx = findDoubleHalfEdgeIndex(edgeErrors, valenceOne);
+            int newDheIdx = edgeErrorIdxs[valenceOne];
             assert(newDheIdx != -1);
             auto newDhe = edgeErrors[newDheIdx]; // get double half edge of L grower
 
@@ -322,7 +360,7 @@ void MergeMetrics::generateMotorcycleGraph()
         valenceOne = v.halfEdgeIdxs[path2EdgeIdxs.first];
         while (true)
         {
-            int newDheIdx = findDoubleHalfEdgeIndex(edgeErrors, valenceOne);
+            int newDheIdx = edgeErrorIdxs[valenceOne];
             auto newDhe = edgeErrors[newDheIdx]; // get double half edge of L grower
 
             markTwoHalfEdges(newDhe.halfEdgeIdx1, newDhe.halfEdgeIdx2);
@@ -343,7 +381,7 @@ void MergeMetrics::generateMotorcycleGraph()
         valenceOne = v.halfEdgeIdxs[path2EdgeIdxs.second];
         while (true)
         {
-            int newDheIdx = findDoubleHalfEdgeIndex(edgeErrors, valenceOne);
+            int newDheIdx = edgeErrorIdxs[valenceOne];
             assert(newDheIdx != -1);
             auto newDhe = edgeErrors[newDheIdx]; // get double half edge of L grower
 
@@ -389,8 +427,13 @@ void MergeMetrics::setEdgeErrorMap(const std::vector<DoubleHalfEdge> &dhes)
     minMaxError.y = std::numeric_limits<float>::min();
 
     halfEdgeErrors.resize(mesh.edges.size());
-    for (const auto &dhe : dhes)
+    edgeErrorIdxs.assign(mesh.edges.size(), -1);
+    for (size_t i = 0; i < dhes.size(); i++)
     {
+        const auto &dhe = dhes[i];
+        for (int halfEdgeIdx : {dhe.halfEdgeIdx1, dhe.halfEdgeIdx2})
+            if (edgeErrorIdxs[halfEdgeIdx] == -1)
+                edgeErrorIdxs[halfEdgeIdx] = static_cast<int>(i);
         minMaxError.x = std::min(minMaxError.x, dhe.error);
         minMaxError.y = std::max(minMaxError.y, dhe.error);
         halfEdgeErrors[dhe.halfEdgeIdx1] = dhe.error;
@@ -415,7 +458,7 @@ void MergeMetrics::setValenceVertices()
         for (int idx : edgeIdxs)
         {
             const auto &e = mesh.edges[idx];
-            mesh.points[e.originIdx].halfEdgeIdx = idx;
+            mesh.editPoint(e.originIdx).halfEdgeIdx = idx;
         }
     }
     valenceVertices.resize(mesh.points.size());
@@ -447,12 +490,14 @@ void MergeMetrics::setValenceVertices()
         i++;
     }
 
+    lookupValenceVertex.assign(mesh.edges.size(), {0, 0});
     for (auto &v : valenceVertices)
     {
         for (int i = 0; i < 4; i++)
         {
             int edgeIdx = v.halfEdgeIdxs[i];
-            lookupValenceVertex[edgeIdx] = {v.id, i};
+            if (edgeIdx != -1)
+                lookupValenceVertex[edgeIdx] = {v.id, i};
         }
     }
 }
@@ -499,10 +544,11 @@ void MergeMetrics::generateEdgeErrorMap(EdgeErrorDisplay edgeErrorDisplay)
     }
     auto glCurveData = getAllPatchGLData(edgeErrorPatches, &Patch::getCurveData);
     auto [w, h] = mergeSettings.aabb.getRes(1000);
-    setupFBO(patchRenderResources.unmergedTexture, unmergedFbo, w, h);
+    setupFBO(patchRenderResources.unmergedTexture, getFramebuffer(false), w, h);
     glLineWidth(10.0f);
     drawPrimitive(glCurveData, patchRenderResources.curveShaderId, mergeSettings.globalPaddedAABB, VERTS_PER_CURVE);
-    writeToImage(1000, EDGE_MAP_IMG);
+    if (mergeSettings.writeDebugImages)
+        writeToImage(1000, EDGE_MAP_IMG);
     closeFBO();
 }
 
@@ -518,21 +564,16 @@ void MergeMetrics::setAABB()
     mergeSettings.aabb = newAABB;
     mergeSettings.globalPaddedAABB = newAABB;
     mergeSettings.globalAABBRes = newAABB.getRes(mergeSettings.poolRes);
+    ssimReference.reset(); // the original has to be recaptured at the new resolution
 }
 
-void MergeMetrics::captureGlobalImage(const std::vector<GLfloat> &glPatches, const char *imgPath)
+void MergeMetrics::captureGlobalImage(const std::vector<GLfloat> &glPatches, Image &image, const char *debugImgPath)
 {
-    FBtoImgParams params = {
-        .texture = patchRenderResources.unmergedTexture,
-        .fbo = unmergedFbo,
-        .width = mergeSettings.globalAABBRes.first,
-        .height = mergeSettings.globalAABBRes.second,
-        .imgPath = imgPath,
-        .glPatches = glPatches,
-        .shaderId = patchRenderResources.patchShaderId,
-        .aabb = mergeSettings.globalPaddedAABB};
-
-    FBtoImg(params);
+    renderPatches(glPatches, mergeSettings.globalPaddedAABB, mergeSettings.globalAABBRes, false, image);
+    if (&image == &images.original)
+        ssimReference = std::make_shared<const SSIMReference>(images.original.view());
+    if (mergeSettings.writeDebugImages && debugImgPath)
+        writeImagePNG(image.view(), debugImgPath);
 }
 
 void MergeMetrics::captureBeforeMerge(const std::vector<GLfloat> &glPatches, AABB &aabb)
@@ -549,191 +590,188 @@ void MergeMetrics::captureBeforeMerge(const std::vector<GLfloat> &glPatches, AAB
     // float lRatio = aabb.length() / mergeSettings.globalPaddedAABB.length();
     // mergeSettings.aabbRes = {mergeSettings.globalAABBRes.first * wRatio, mergeSettings.globalAABBRes.second * lRatio};
     mergeSettings.aabbRes = mergeSettings.globalAABBRes;
-    FBtoImgParams params = {
-        .texture = patchRenderResources.unmergedTexture,
-        .fbo = unmergedFbo,
-        .width = mergeSettings.aabbRes.first,
-        .height = mergeSettings.aabbRes.second,
-        .imgPath = PREV_METRIC_IMG,
-        .glPatches = glPatches,
-        .shaderId = patchRenderResources.patchShaderId,
-        .aabb = aabb};
-
-    FBtoImg(params);
+    renderPatches(glPatches, aabb, mergeSettings.aabbRes, false, images.previous);
+    if (mergeSettings.writeDebugImages)
+        writeImagePNG(images.previous.view(), PREV_METRIC_IMG);
 }
 
-void MergeMetrics::captureAfterMerge(const std::vector<GLfloat> &glPatches, const char *imgPath)
+void MergeMetrics::captureAfterMerge(const std::vector<GLfloat> &glPatches, Image &image, const char *debugImgPath)
 {
-    FBtoImgParams params = {
-        .texture = patchRenderResources.mergedTexture,
-        .fbo = mergedFbo,
-        .width = mergeSettings.aabbRes.first,
-        .height = mergeSettings.aabbRes.second,
-        .imgPath = imgPath,
-        .glPatches = glPatches,
-        .shaderId = patchRenderResources.patchShaderId,
-        .aabb = mergeSettings.aabb};
-
-    FBtoImg(params);
+    renderPatches(glPatches, mergeSettings.aabb, mergeSettings.aabbRes, true, image);
+    if (mergeSettings.writeDebugImages && debugImgPath)
+        writeImagePNG(image.view(), debugImgPath);
 }
 
-float MergeMetrics::getMergeError(const std::vector<GLfloat> &glPatches, const char *imgPath)
+float MergeMetrics::getMergeError(const std::vector<GLfloat> &glPatches, Image &image, const char *debugImgPath)
 {
     switch (mergeSettings.pixelRegion)
     {
     case PixelRegion::Global:
-        captureGlobalImage(glPatches, imgPath);
-        return evaluateMetric(imgPath, ORIG_IMG);
+        captureGlobalImage(glPatches, image, debugImgPath);
+        return evaluateGlobalMetric(image.view());
     case PixelRegion::Local:
-        captureAfterMerge(glPatches, imgPath);
-        return evaluateMetric(imgPath, PREV_METRIC_IMG);
+        captureAfterMerge(glPatches, image, debugImgPath);
+        return evaluateMetric(image.view(), images.previous.view());
     }
     return 1.0f;
 }
 
-float MergeMetrics::evaluateMetric(const char *compImgPath, const char *compImgPath2)
+void MergeMetrics::captureGlobalImage(Image &image, const char *debugImgPath)
 {
-    switch (mergeSettings.metricMode)
-    {
-    case SSIM:
-        return 1.0f - evaluateSSIM(compImgPath2, compImgPath);
-    case FLIP:
-        return evaluateFLIP(compImgPath2, compImgPath);
-    }
-    return -1;
+    renderPatches(patchBuffer.getData(), mergeSettings.globalPaddedAABB, mergeSettings.globalAABBRes, false, image, &patchBuffer);
+    if (mergeSettings.writeDebugImages && debugImgPath)
+        writeImagePNG(image.view(), debugImgPath);
 }
 
-void saveErrorMapAsPNG(float *errorMap, int width, int height, const char *filename)
+float MergeMetrics::getMergeError(Image &image, const char *debugImgPath)
 {
-    // Find the min and max values in the error map to normalize the data
-    float minError = FLT_MAX, maxError = -FLT_MAX;
-    for (int i = 0; i < width * height; ++i)
-    {
-        errorMap[i] = 1 - errorMap[i];
-        if (errorMap[i] < minError)
-            minError = errorMap[i];
-        if (errorMap[i] > maxError)
-            maxError = errorMap[i];
-    }
-
-    // Normalize the error map values to [0, 255] range
-    unsigned char *imageData = new unsigned char[width * height]; // Single channel image (grayscale)
-    for (int i = 0; i < width * height; ++i)
-    {
-        float normalizedValue = (errorMap[i] - minError) / (maxError - minError);
-        imageData[i] = static_cast<unsigned char>(normalizedValue * 255.0f);
-    }
-
-    // Save the image using stb_image_write
-    if (!stbi_write_png(filename, width, height, 1, imageData, width))
+    switch (mergeSettings.pixelRegion)
     {
-        std::cerr << "Error writing PNG file." << std::endl;
+    case PixelRegion::Global:
+        captureGlobalImage(image, debugImgPath);
+        return evaluateGlobalMetric(image.view());
+    case PixelRegion::Local:
+        renderPatches(patchBuffer.getData(), mergeSettings.aabb, mergeSettings.aabbRes, true, image, &patchBuffer);
+        if (mergeSettings.writeDebugImages && debugImgPath)
+            writeImagePNG(image.view(), debugImgPath);
+        return evaluateMetric(image.view(), images.previous.view());
     }
-
-    delete[] imageData; // Clean up the allocated image data
+    return 1.0f;
 }
 
-float evaluateFLIP(const char *img1Path, const char *img2Path)
+// Captures the given mesh render as the current image and compares it against the original
+float MergeMetrics::getGlobalError(const std::vector<GLfloat> &glPatches)
 {
+    captureGlobalImage(glPatches, images.current, CURR_IMG);
+    return evaluateGlobalMetric(images.current.view());
+}
 
-    int img1Width, img1Height, img1ChannelCount;
-    float *img1 = stbi_loadf(img1Path, &img1Width, &img1Height, &img1ChannelCount, 0);
-    if (img1 == NULL)
-    {
-        fprintf(stderr, "Failed to load image \"%s\": %s\n", img1Path, stbi_failure_reason());
-        return -1;
-    }
+void MergeMetrics::rasterizeBeforeMerge(const std::vector<GLfloat> &glPatches, AABB &aabb, Image &previous) const
+{
+    if (mergeSettings.pixelRegion == PixelRegion::Global)
+        return;
 
-    int img2Width, img2Height, img2ChannelCount;
-    float *img2 = stbi_loadf(img2Path, &img2Width, &img2Height, &img2ChannelCount, 0);
-    if (img2 == NULL)
-    {
-        fprintf(stderr, "Failed to load image \"%s\": %s\n", img2Path, stbi_failure_reason());
-        return -1;
-    }
+    aabb.addPadding(mergeSettings.aabbPadding);
+    aabb.ensureSize(MIN_AABB_SIZE);
+    rasterizePatches(glPatches, aabb, mergeSettings.globalAABBRes.first, mergeSettings.globalAABBRes.second, previous);
+}
 
-    if (img1Width != img2Width || img1Height != img2Height || img1ChannelCount != img2ChannelCount)
+float MergeMetrics::rasterizeMergeError(MetricContext &context, IncrementalSSIM &ssim, const std::vector<GLfloat> &glPatches, const AABB &aabb, const Image &previous, Image &image) const
+{
+    switch (mergeSettings.pixelRegion)
     {
-        fprintf(stderr, "Images must have the same dimensions and number of channels\n");
-        return -1;
+    case PixelRegion::Global:
+        rasterizeGlobalImage(glPatches, image);
+        // the same incremental scoring as evaluateGlobalMetric
+        if (!useNativeSSIM(images.original.view()))
+            return evaluateMetric(context, image.view());
+        if (ssim.getReference() != ssimReference)
+            ssim.setReference(ssimReference);
+        return 1.0f - ssim.score(image.view());
+    case PixelRegion::Local:
+        rasterizePatches(glPatches, aabb, mergeSettings.globalAABBRes.first, mergeSettings.globalAABBRes.second, image);
+        return evaluateMetric(context, image.view(), previous.view());
     }
-    float meanFLIPError;
-    FLIP::Parameters parameters;
-    float *errorMapFLIPOutput = new float[img1Width * img1Height];
-
-    FLIP::evaluate(img1, img2, img1Width, img1Height, false, parameters, false, true, meanFLIPError, &errorMapFLIPOutput);
-    saveErrorMapAsPNG(errorMapFLIPOutput, img1Width, img1Height, "img/errormap.png");
+    return 1.0f;
+}
 
-    delete[] errorMapFLIPOutput; // If FLIP doesn't manage this internally
-    stbi_image_free(img1);
-    stbi_image_free(img2);
+// Error against the original image. Global SSIM goes through the incremental engine, whose cached tiles belong to the
+// image it scored last, so consecutive trial merges only pay for the pixels they changed. An error map needs the
+// whole map, which the same reference scores from scratch.
+float MergeMetrics::evaluateGlobalMetric(const ImageView &compImg)
+{
+    if (!useNativeSSIM(images.original.view()) || mergeSettings.writeDebugImages)
+        return evaluateMetric(compImg, images.original.view());
+    if (globalSSIM.getReference() != ssimReference)
+        globalSSIM.setReference(ssimReference);
+    return 1.0f - globalSSIM.score(compImg);
+}
 
-    return meanFLIPError;
+// Whether the prepared statistics of the original serve as the reference
+bool MergeMetrics::useNativeSSIM(const ImageView &refImg) const
+{
+    return mergeSettings.metricMode == MetricMode::SSIM && mergeSettings.nativeSSIM && ssimReference &&
+           refImg.data == images.original.pixels.data() && ssimReference->sameShape(refImg);
 }
 
-float evaluateSSIM(const char *img1Path, const char *img2Path)
+// Renders the same patches with both backends and reports how far the software rasterizer is from the GL pipeline
+ImageDifference MergeMetrics::compareRenderBackends(const std::vector<GLfloat> &glPatches)
 {
-    int img1Width, img1Height, img1ChannelCount;
-    stbi_uc *img1 = stbi_load(img1Path, &img1Width, &img1Height, &img1ChannelCount, 0);
-    if (img1 == NULL)
-    {
-        fprintf(stderr, "Failed to load image \"%s\": %s\n", img1Path, stbi_failure_reason());
-        return -1;
-    }
+    auto res = mergeSettings.globalAABBRes;
+    const AABB &aabb = mergeSettings.globalPaddedAABB;
+    FBtoImgParams params = {
+        .texture = patchRenderResources.mergedTexture,
+        .fbo = getFramebuffer(true),
+        .width = res.first,
+        .height = res.second,
+        .image = images.merged,
+        .glPatches = glPatches,
+        .shaderId = patchRenderResources.patchShaderId,
+        .aabb = aabb};
+    FBtoImg(params);
 
-    int img2Width, img2Height, img2ChannelCount;
-    stbi_uc *img2 = stbi_load(img2Path, &img2Width, &img2Height, &img2ChannelCount, 0);
-    if (img2 == NULL)
+    Image cpuImage;
+    rasterizePatches(glPatches, aabb, res.first, res.second, cpuImage);
+    ImageDifference diff = compareImages(images.merged.view(), cpuImage.view());
+    std::cout << "render backends: " << diff.differingPixels << " of " << res.first * res.second
+              << " pixels differ, max channel difference " << diff.maxChannelDifference
+              << ", metric error " << evaluateMetric(cpuImage.view(), images.merged.view()) << std::endl;
+    if (mergeSettings.writeDebugImages)
     {
-        fprintf(stderr, "Failed to load image \"%s\": %s\n", img2Path, stbi_failure_reason());
-        return -1;
+        writeImagePNG(images.merged.view(), "img/backendGL.png");
+        writeImagePNG(cpuImage.view(), "img/backendCPU.png");
     }
+    return diff;
+}
 
-    if (img1Width != img2Width || img1Height != img2Height || img1ChannelCount != img2ChannelCount)
-    {
-        fprintf(stderr, "Images must have the same dimensions and number of channels\n");
-        return -1;
-    }
+// Scores the given mesh render against the original with the native SSIM and with rmgr and reports how far apart the
+// mean scores and the maps are, see MetricContext::compareSSIM
+MetricDifference MergeMetrics::compareSSIMEngines(const std::vector<GLfloat> &glPatches)
+{
+    if (images.original.empty())
+        return {};
+    captureGlobalImage(glPatches, images.merged);
+    MetricDifference diff = metricContext.compareSSIM(images.original.view(), images.merged.view());
+    std::cout << "SSIM engines: native " << diff.nativeMean << ", library " << diff.libraryMean
+              << ", max pixel difference " << diff.maxPixelDifference << std::endl;
+    return diff;
+}
+
+float MergeMetrics::evaluateMetric(const ImageView &compImg, const ImageView &refImg)
+{
+    return evaluateMetric(metricContext, compImg, refImg, mergeSettings.writeDebugImages ? ERROR_MAP_IMG : nullptr);
+}
+
+float MergeMetrics::evaluateMetric(MetricContext &context, const ImageView &compImg, const char *errorMapPath) const
+{
+    return evaluateMetric(context, compImg, images.original.view(), errorMapPath);
+}
 
-    // Compute SSIM of each channel
-    rmgr::ssim::Params params;
-    memset(&params, 0, sizeof(params));
-    params.width = img1Width;
-    params.height = img1Height;
-    float *ssimMap = new float[img1Width * img1Height];
-    params.ssimMap = ssimMap;
-    params.ssimStep = 1; // Horizontal step for SSIM map in `float`s
-    params.ssimStride = img1Width;
-
-    float totalSSIM = 0;
-    for (int channelNum = 0; channelNum < img1ChannelCount; ++channelNum)
+float MergeMetrics::evaluateMetric(MetricContext &context, const ImageView &compImg, const ImageView &refImg, const char *errorMapPath) const
+{
+    switch (mergeSettings.metricMode)
     {
-        params.imgA.init_interleaved(img1, img1Width * img1ChannelCount, img1ChannelCount, channelNum);
-        params.imgB.init_interleaved(img2, img2Width * img2ChannelCount, img2ChannelCount, channelNum);
-        // #if RMGR_SSIM_USE_OPENMP
-        //        const float ssim = rmgr::ssim::compute_ssim_openmp(params);
-        // #else
-        const float ssim = rmgr::ssim::compute_ssim(params);
-        // #endif
-        if (rmgr::ssim::get_errno(ssim) != 0)
-            fprintf(stderr, "Failed to compute SSIM of channel %d\n", channelNum + 1);
-
-        totalSSIM += ssim;
+    case SSIM:
+        if (useNativeSSIM(refImg))
+            return 1.0f - context.evaluateSSIM(*ssimReference, compImg, errorMapPath);
+        // a local reference is only compared once, it is prepared for that comparison
+        if (mergeSettings.nativeSSIM)
+            return 1.0f - context.evaluateSSIM(SSIMReference{refImg}, compImg, errorMapPath);
+        return 1.0f - context.evaluateSSIM(refImg, compImg, errorMapPath);
+    case FLIP:
+        return context.evaluateFLIP(refImg, compImg, errorMapPath);
     }
-
-    saveErrorMapAsPNG(ssimMap, img1Width, img1Height, "img/errormap.png");
-    //  Clean up
-    delete[] ssimMap;
-    stbi_image_free(img2);
-    stbi_image_free(img1);
-    return totalSSIM * (1.0f / img1ChannelCount);
+    return -1;
 }
 
 void FBtoImg(const FBtoImgParams &params)
 {
     setupFBO(params.texture, params.fbo, params.width, params.height);
-    drawPrimitive(params.glPatches, params.shaderId, params.aabb, VERTS_PER_PATCH);
-    writeToImage(params.width, params.height, params.imgPath);
+    if (params.patchBuffer)
+        drawPrimitive(*params.patchBuffer, params.shaderId, params.aabb);
+    else
+        drawPrimitive(params.glPatches, params.shaderId, params.aabb, VERTS_PER_PATCH);
+    readPixels(params.width, params.height, params.image);
     closeFBO();
 }
 
@@ -756,32 +794,34 @@ void closeFBO()
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void writeToImage(int resolution, const char *imgPath)
+void readPixels(int width, int height, Image &image)
+{
+    image.resize(width, height, 3); // 3 channels for RGB
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); // very important
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, image.pixels.data());
+}
+
+bool writeImagePNG(const ImageView &image, const char *imgPath)
 {
-    std::vector<uint8_t> pixelsA(resolution * resolution * 3); // 3 channels for RGB
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);                       // very important
-    glReadPixels(0, 0, resolution, resolution, GL_RGB, GL_UNSIGNED_BYTE, pixelsA.data());
-    int stride_bytes = resolution * 3;
     std::remove(imgPath);
-    if (!stbi_write_png(imgPath, resolution, resolution, 3, pixelsA.data(), stride_bytes))
+    if (!stbi_write_png(imgPath, image.width, image.height, image.channels, image.data, image.width * image.channels))
     {
         std::cerr << "Failed to write PNG: " << imgPath << std::endl;
-        return;
+        return false;
     }
+    return true;
+}
+
+void writeToImage(int resolution, const char *imgPath)
+{
+    writeToImage(resolution, resolution, imgPath);
 }
 
 void writeToImage(int width, int height, const char *imgPath)
 {
-    std::vector<uint8_t> pixelsA(width * height * 3); // 3 channels for RGB
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);              // very important
-    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixelsA.data());
-    int stride_bytes = width * 3;
-    std::remove(imgPath);
-    if (!stbi_write_png(imgPath, width, height, 3, pixelsA.data(), stride_bytes))
-    {
-        std::cerr << "Failed to write PNG: " << imgPath << std::endl;
-        return;
-    }
+    Image image;
+    readPixels(width, height, image);
+    writeImagePNG(image.view(), imgPath);
 }
 
 GLuint LoadTextureFromFile(const char *filename)
@@ -807,4 +847,18 @@ GLuint LoadTextureFromFile(const char *filename)
     stbi_image_free(image_data);
 
     return texture;
-}
\ No newline at end of file
+}
+
+void uploadImageToTexture(const ImageView &image, GLuint texture)
+{
+    if (image.empty())
+        return;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
@@ -135,10 +135,11 @@ void MergeSelect::detectOverlappingCorners()
 
 void MergeSelect::findCandidateMerges(std::vector<SingleHalfEdge> *boundaryEdges)
 {
-    auto &candidateMerges = state.candidateMerges;
-    candidateMerges.clear();
+    auto &mesh = state.mesh;
+    state.candidateMerges.rebuild(mesh);
+    if (!boundaryEdges)
+        return;
     int faceIdx = 0;
-    auto mesh = state.mesh;
     for (auto &face : mesh.getFaces())
     {
         if (face.isValid())
@@ -147,27 +148,8 @@ void MergeSelect::findCandidateMerges(std::vector<SingleHalfEdge> *boundaryEdges
             for (int i = 0; i < 4; i++)
             {
                 const auto &currEdge = mesh.edges[currIdx];
-                if (mesh.validMergeEdge(currEdge))
-                {
-                    auto findEdgeIdx = std::find_if(candidateMerges.begin(), candidateMerges.end(), [currIdx](const DoubleHalfEdge &dhe)
-                                                    { return dhe.halfEdgeIdx2 == currIdx; });
-
-                    if (findEdgeIdx == candidateMerges.end())
-                    {
-                        candidateMerges.push_back(DoubleHalfEdge{currIdx, currEdge.twinIdx, CurveId{faceIdx, i}});
-                    }
-                    else
-                    {
-                        size_t foundIndex = std::distance(candidateMerges.begin(), findEdgeIdx);
-                        // assert(currIdx != candidateMerges[foundIndex].halfEdgeIdx2)
-                        candidateMerges[foundIndex]
-                            .curveId2 = CurveId{faceIdx, i};
-                    }
-                }
-                else if (boundaryEdges)
-                {
+                if (!mesh.validMergeEdge(currEdge))
                     boundaryEdges->push_back(SingleHalfEdge{CurveId{faceIdx, i}, currIdx});
-                }
                 currIdx = currEdge.nextIdx;
             }
             faceIdx++;
@@ -175,6 +157,11 @@ void MergeSelect::findCandidateMerges(std::vector<SingleHalfEdge> *boundaryEdges
     }
 }
 
+void MergeSelect::updateCandidateMerges()
+{
+    state.candidateMerges.update(state.mesh);
+}
+
 int MergeSelect::selectEdge()
 {
     switch (state.mergeMode)
@@ -193,28 +180,21 @@ int MergeSelect::selectEdge()
 
 int MergeSelect::selectRandomEdge()
 {
-    switch (state.mergeStatus)
+    // a success changes the candidates, so every one of them is worth trying again
+    if (state.mergeStatus == NA || state.mergeStatus == SUCCESS)
     {
-    case NA:
-    case SUCCESS:
-    {
-        selectedEdgePool = generateRandomNums(state.candidateMerges.size() - 1);
+        state.candidateMerges.resetPicks();
         state.attemptedMergesIdx = 0;
-        break;
     }
-    case CYCLE:
-    case METRIC_ERROR:
+    int slot = state.candidateMerges.pickUntried(gen);
+    if (slot == -1)
     {
-        if (state.attemptedMergesIdx >= selectedEdgePool.size())
-        {
-            state.mergeMode = NONE;
-            return -1;
-        }
-        break;
-    }
+        state.mergeMode = NONE;
+        return -1;
     }
-    state.selectedEdgeId = selectedEdgePool[state.attemptedMergesIdx++];
-    return state.candidateMerges[state.selectedEdgeId].getHalfEdgeIdx();
+    state.attemptedMergesIdx++;
+    state.selectedEdgeId = slot;
+    return state.candidateMerges[slot].getHalfEdgeIdx();
 }
 
 int MergeSelect::selectVerticalGridEdge()
@@ -318,7 +298,7 @@ int MergeSelect::selectDualGridEdge()
 
             int rightMostStem = -1;
             float maxInterval = 0.0f;
-            for (int childIdx : tParent1.childrenIdxs)
+            for (int childIdx : state.mesh.getChildren(tParent1))
             {
                 if (state.mesh.edges[childIdx].isStem() && state.mesh.edges[childIdx].interval.x > maxInterval)
                 {
@@ -0,0 +1,204 @@
+#include "metric_context.hpp"
+#include "incremental_ssim.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <rmgr/ssim.h>
+#include <FLIP.h>
+
+#include "stb_image_write.h"
+
+const std::array<float, 256> &ldrToFloatTable()
+{
+    static const std::array<float, 256> table = []
+    {
+        std::array<float, 256> t;
+        for (int i = 0; i < 256; i++)
+            t[i] = std::pow(i / 255.0f, 2.2f);
+        return t;
+    }();
+    return table;
+}
+
+static bool checkSameShape(const ImageView &img1, const ImageView &img2)
+{
+    if (img1.empty() || img2.empty())
+    {
+        fprintf(stderr, "Cannot evaluate metric on an empty image\n");
+        return false;
+    }
+    if (!img1.sameShape(img2))
+    {
+        fprintf(stderr, "Images must have the same dimensions and number of channels\n");
+        return false;
+    }
+    return true;
+}
+
+void MetricContext::saveErrorMap(float *errorMap, int width, int height, const char *path)
+{
+    // Find the min and max values in the error map to normalize the data
+    float minError = FLT_MAX, maxError = -FLT_MAX;
+    for (int i = 0; i < width * height; ++i)
+    {
+        errorMap[i] = 1 - errorMap[i];
+        if (errorMap[i] < minError)
+            minError = errorMap[i];
+        if (errorMap[i] > maxError)
+            maxError = errorMap[i];
+    }
+
+    // Normalize the error map values to [0, 255] range, single channel image (grayscale)
+    errorMapPixels.resize(static_cast<size_t>(width) * height);
+    for (int i = 0; i < width * height; ++i)
+    {
+        float normalizedValue = (errorMap[i] - minError) / (maxError - minError);
+        errorMapPixels[i] = static_cast<unsigned char>(normalizedValue * 255.0f);
+    }
+
+    if (!stbi_write_png(path, width, height, 1, errorMapPixels.data(), width))
+    {
+        std::cerr << "Error writing PNG file " << path << std::endl;
+    }
+}
+
+float MetricContext::evaluateFLIP(const ImageView &img1, const ImageView &img2, const char *errorMapPath)
+{
+    if (!checkSameShape(img1, img2))
+        return -1;
+
+    const auto &table = ldrToFloatTable();
+    img1Float.resize(img1.size());
+    img2Float.resize(img2.size());
+    for (size_t i = 0; i < img1.size(); i++)
+    {
+        img1Float[i] = table[img1.data[i]];
+        img2Float[i] = table[img2.data[i]];
+    }
+
+    float meanFLIPError;
+    FLIP::Parameters parameters;
+    // FLIP writes into a non-null map instead of allocating one
+    flipErrorMap.resize(static_cast<size_t>(img1.width) * img1.height);
+    float *errorMapFLIPOutput = flipErrorMap.data();
+
+    FLIP::evaluate(img1Float.data(), img2Float.data(), img1.width, img1.height, false, parameters, false, true, meanFLIPError, &errorMapFLIPOutput);
+    if (errorMapPath)
+        saveErrorMap(flipErrorMap.data(), img1.width, img1.height, errorMapPath);
+
+    return meanFLIPError;
+}
+
+float MetricContext::evaluateSSIM(const ImageView &img1, const ImageView &img2, const char *errorMapPath)
+{
+    if (!checkSameShape(img1, img2))
+        return -1;
+
+    // Compute SSIM of each channel
+    rmgr::ssim::Params params;
+    memset(&params, 0, sizeof(params));
+    params.width = img1.width;
+    params.height = img1.height;
+    if (errorMapPath)
+    {
+        ssimMap.resize(static_cast<size_t>(img1.width) * img1.height);
+        params.ssimMap = ssimMap.data();
+        params.ssimStep = 1; // Horizontal step for SSIM map in `float`s
+        params.ssimStride = img1.width;
+    }
+
+    float totalSSIM = 0;
+    for (int channelNum = 0; channelNum < img1.channels; ++channelNum)
+    {
+        params.imgA.init_interleaved(img1.data, img1.width * img1.channels, img1.channels, channelNum);
+        params.imgB.init_interleaved(img2.data, img2.width * img2.channels, img2.channels, channelNum);
+        // #if RMGR_SSIM_USE_OPENMP
+        //        const float ssim = rmgr::ssim::compute_ssim_openmp(params);
+        // #else
+        const float ssim = rmgr::ssim::compute_ssim(params);
+        // #endif
+        if (rmgr::ssim::get_errno(ssim) != 0)
+            fprintf(stderr, "Failed to compute SSIM of channel %d\n", channelNum + 1);
+
+        totalSSIM += ssim;
+    }
+
+    if (errorMapPath)
+        saveErrorMap(ssimMap.data(), img1.width, img1.height, errorMapPath);
+    return totalSSIM * (1.0f / img1.channels);
+}
+
+float MetricContext::evaluateSSIM(const SSIMReference &reference, const ImageView &img, const char *errorMapPath)
+{
+    if (img.empty() || !reference.sameShape(img))
+    {
+        fprintf(stderr, "Images must have the same dimensions and number of channels\n");
+        return -1;
+    }
+
+    const size_t mapSize = static_cast<size_t>(reference.mapWidth()) * reference.mapHeight();
+    if (!errorMapPath || mapSize == 0)
+        return reference.score(img);
+
+    nativeSSIMMap.resize(mapSize * img.channels);
+    const float ssim = reference.score(img, nativeSSIMMap.data());
+    // the error map shows the mean over the channels
+    ssimMap.resize(mapSize);
+    for (size_t i = 0; i < mapSize; i++)
+    {
+        float sum = 0.0f;
+        for (int channelNum = 0; channelNum < img.channels; ++channelNum)
+            sum += nativeSSIMMap[i * img.channels + channelNum];
+        ssimMap[i] = sum / img.channels;
+    }
+    saveErrorMap(ssimMap.data(), reference.mapWidth(), reference.mapHeight(), errorMapPath);
+    return ssim;
+}
+
+// rmgr's map covers every pixel, a native window position lines up with the pixel at the centre of its window
+MetricDifference MetricContext::compareSSIM(const ImageView &refImg, const ImageView &img)
+{
+    MetricDifference diff;
+    if (!checkSameShape(refImg, img))
+        return diff;
+
+    SSIMReference reference{refImg};
+    const int mapWidth = reference.mapWidth();
+    const int mapHeight = reference.mapHeight();
+    nativeSSIMMap.resize(static_cast<size_t>(mapWidth) * mapHeight * img.channels);
+    diff.nativeMean = reference.score(img, nativeSSIMMap.data());
+
+    rmgr::ssim::Params params;
+    memset(&params, 0, sizeof(params));
+    params.width = img.width;
+    params.height = img.height;
+    ssimMap.resize(static_cast<size_t>(img.width) * img.height);
+    params.ssimMap = ssimMap.data();
+    params.ssimStep = 1;
+    params.ssimStride = img.width;
+
+    float totalSSIM = 0;
+    for (int channelNum = 0; channelNum < img.channels; ++channelNum)
+    {
+        params.imgA.init_interleaved(refImg.data, refImg.width * refImg.channels, refImg.channels, channelNum);
+        params.imgB.init_interleaved(img.data, img.width * img.channels, img.channels, channelNum);
+        totalSSIM += rmgr::ssim::compute_ssim(params);
+        for (int my = 0; my < mapHeight; my++)
+        {
+            for (int mx = 0; mx < mapWidth; mx++)
+            {
+                const float native = nativeSSIMMap[(static_cast<size_t>(my) * mapWidth + mx) * img.channels + channelNum];
+                const float library = ssimMap[static_cast<size_t>(my + SSIM_WINDOW_RADIUS) * img.width + mx + SSIM_WINDOW_RADIUS];
+                diff.maxPixelDifference = std::max(diff.maxPixelDifference, std::abs(native - library));
+            }
+        }
+    }
+    diff.libraryMean = totalSSIM * (1.0f / img.channels);
+    return diff;
+}
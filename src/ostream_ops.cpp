@@ -101,20 +101,8 @@ std::ostream &operator<<(std::ostream &os, const HalfEdge &edge)
         << "\n  Twin Index: " << edge.twinIdx
         << "\n  Parent Index: " << edge.parentIdx
         << "\n  Child Index Degenerate: " << edge.childIdxDegenerate
-        << "\n  Children Indices: \n  [";
-
-    // Print children indices
-    for (size_t i = 0; i < edge.childrenIdxs.size(); ++i)
-    {
-        os << edge.childrenIdxs[i];
-        if (i != edge.childrenIdxs.size() - 1)
-        {
-            os << ", ";
-        }
-        if (i != 0 && i % 6 == 0 && i != edge.childrenIdxs.size() - 1)
-            os << "\n  ";
-    }
-    os << "]\n";
+        // the indices themselves live in the mesh, see GradMesh::getChildren
+        << "\n  Children: " << edge.children.count << " at " << edge.children.first << " in the child arena\n";
 
     return os;
 }
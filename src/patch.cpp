@@ -80,33 +80,71 @@ Vertex Patch::findPatchPoint(float u, float v) const
     return cmXv[0] * uVec[0] + cmXv[1] * uVec[1] + cmXv[2] * uVec[2] + cmXv[3] * uVec[3];
 }
 
-double Patch::isPointInsidePatch(const glm::vec2 &P, double tolerance) const
+glm::vec2 Patch::evaluateCoords(float u, float v, glm::vec2 &du, glm::vec2 &dv) const
 {
-    double best_u = 0.0, best_v = 0.0;
-    double min_dist = std::numeric_limits<double>::infinity();
-
-    const int steps = 50; // Increase for better precision
-    for (int i = 0; i <= steps; ++i)
+    glm::vec4 vVec = glm::vec4(1.0f, v, v * v, v * v * v) * hermiteBasisMat;
+    glm::vec4 vDer = glm::vec4(0.0f, 1.0f, 2.0f * v, 3.0f * v * v) * hermiteBasisMat;
+    glm::vec4 uVec = glm::vec4(1.0f, u, u * u, u * u * u) * hermiteBasisMat;
+    glm::vec4 uDer = glm::vec4(0.0f, 1.0f, 2.0f * u, 3.0f * u * u) * hermiteBasisMat;
+    glm::vec2 point{0.0f};
+    du = dv = glm::vec2{0.0f};
+    for (int row = 0; row < 4; ++row)
     {
-        for (int j = 0; j <= steps; ++j)
+        glm::vec2 cmXv{0.0f}, cmXvDer{0.0f};
+        for (int col = 0; col < 4; ++col)
         {
-            double u = i / static_cast<double>(steps);
-            double v = j / static_cast<double>(steps);
+            const glm::vec2 &coords = controlMatrix[row * 4 + col].coords;
+            cmXv += coords * vVec[col];
+            cmXvDer += coords * vDer[col];
+        }
+        point += cmXv * uVec[row];
+        du += cmXv * uDer[row];
+        dv += cmXvDer * uVec[row];
+    }
+    return point;
+}
 
-            glm::vec2 p_uv = findPatchPoint(u, v).coords;
-            double dist = glm::distance(p_uv, P);
+double Patch::isPointInsidePatch(const glm::vec2 &P, double tolerance) const
+{
+    glm::vec2 du, dv;
 
+    // Seed from the closest sample of a coarse grid, the map is close enough to linear within one cell
+    const int seedSteps = 4;
+    float u = 0.0f, v = 0.0f;
+    float min_dist = std::numeric_limits<float>::infinity();
+    for (int i = 0; i <= seedSteps; ++i)
+    {
+        for (int j = 0; j <= seedSteps; ++j)
+        {
+            float su = i / static_cast<float>(seedSteps);
+            float sv = j / static_cast<float>(seedSteps);
+            float dist = glm::distance(evaluateCoords(su, sv, du, dv), P);
             if (dist < min_dist)
             {
                 min_dist = dist;
-                best_u = u;
-                best_v = v;
+                u = su;
+                v = sv;
             }
         }
     }
-    if (best_u >= 0 && best_u <= 1 && best_v >= 0 && best_v <= 1)
-        return min_dist;
-    return 1;
+
+    // Newton on F(u, v) = P, clamped to the parameter domain so points outside end up on the boundary
+    const int maxIterations = 20;
+    for (int iter = 0; iter < maxIterations && min_dist > 1e-6f; ++iter)
+    {
+        glm::vec2 residual = evaluateCoords(u, v, du, dv) - P;
+        float det = du.x * dv.y - du.y * dv.x;
+        if (std::abs(det) < 1e-12f)
+            break;
+        float stepU = (dv.y * residual.x - dv.x * residual.y) / det;
+        float stepV = (du.x * residual.y - du.y * residual.x) / det;
+        u = std::clamp(u - stepU, 0.0f, 1.0f);
+        v = std::clamp(v - stepV, 0.0f, 1.0f);
+        min_dist = std::min(min_dist, glm::distance(evaluateCoords(u, v, du, dv), P));
+        if (std::abs(stepU) + std::abs(stepV) < 1e-7f)
+            break;
+    }
+    return min_dist;
 }
 
 const std::vector<GLfloat> getAllHandleGLPoints(const std::vector<Vertex> &handles, int firstIdx, int step)
@@ -171,28 +209,3 @@ int getSelectedPatch(const std::vector<Patch> &patches, glm::vec2 pos)
     }
     return selectedPatchIdx;
 }
-
-int getPatchFromFaceIdx(const std::vector<Patch> &patches, int faceIdx)
-{
-    for (size_t i = 0; i < patches.size(); ++i)
-        if (patches[i].getFaceIdx() == faceIdx)
-            return i;
-    return -1;
-}
-
-CurveId getCurveIdFromEdgeIdx(const std::vector<Patch> &patches, int targetEdgeIdx)
-{
-    for (size_t i = 0; i < patches.size(); ++i)
-    {
-        const auto allHalfEdgeIdxs(patches[i].getCurves() //
-                                   | std::views::transform([](const Curve &curve)
-                                                           { return curve.getHalfEdgeIdx(); }));
-
-        auto it = std::ranges::find(allHalfEdgeIdxs, targetEdgeIdx);
-        if (it != allHalfEdgeIdxs.end())
-        {
-            return CurveId{static_cast<int>(i), static_cast<int>(std::distance(allHalfEdgeIdxs.begin(), it))};
-        }
-    }
-    return CurveId{-1, -1};
-}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "patch_cache.hpp"
+#include "gradmesh.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+    uint64_t nextPatchVersion()
+    {
+        static std::atomic<uint64_t> version{0};
+        return ++version;
+    }
+}
+
+bool PatchCache::update(const GradMesh &mesh)
+{
+    const auto &faces = mesh.getFaces();
+    if (!built)
+    {
+        rebuild(mesh);
+    }
+    else
+    {
+        updateParentIndex(mesh);
+        const auto &dirtyFaceIdxs = collectDirtyFaces(mesh);
+        facePatches.resize(faces.size());
+        faceVersions.resize(faces.size(), 0);
+        for (int faceIdx : dirtyFaceIdxs)
+        {
+            facePatches[faceIdx] = faces[faceIdx].isValid() ? mesh.generatePatch(faceIdx) : std::nullopt;
+            faceVersions[faceIdx] = nextPatchVersion();
+        }
+    }
+    dirtyEdges.reset(mesh.getEdges().size());
+    dirtyHandles.reset(mesh.getHandles().size());
+    dirtyFaces.reset(faces.size());
+
+    for (size_t faceIdx = 0; faceIdx < faces.size(); faceIdx++)
+        if (faces[faceIdx].isValid() && !facePatches[faceIdx])
+            return false;
+    return true;
+}
+
+std::vector<Patch> PatchCache::getPatches() const
+{
+    std::vector<Patch> patches;
+    patches.reserve(facePatches.size());
+    for (const auto &patch : facePatches)
+        if (patch)
+            patches.push_back(patch.value());
+    return patches;
+}
+
+void PatchCache::rebuild(const GradMesh &mesh)
+{
+    const auto &faces = mesh.getFaces();
+    facePatches.assign(faces.size(), std::nullopt);
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int faceIdx = 0; faceIdx < static_cast<int>(faces.size()); faceIdx++)
+        if (faces[faceIdx].isValid())
+            facePatches[faceIdx] = mesh.generatePatch(faceIdx);
+    faceVersions.resize(faces.size());
+    for (auto &version : faceVersions)
+        version = nextPatchVersion();
+
+    const size_t numEdges = mesh.getEdges().size();
+    firstParentByNext.assign(numEdges, -1);
+    nextParentByNext.assign(numEdges, -1);
+    indexedNextIdx.assign(numEdges, -1);
+    for (size_t edgeIdx = 0; edgeIdx < numEdges; edgeIdx++)
+        indexParent(mesh, edgeIdx);
+    built = true;
+}
+
+// A parent only changes its next edge or children through editEdge, so the marked and appended edges are the only ones
+// to relist. Edges a rollback dropped are unlisted, together with the parents listed under them.
+void PatchCache::updateParentIndex(const GradMesh &mesh)
+{
+    const size_t numEdges = mesh.getEdges().size();
+    for (size_t edgeIdx = numEdges; edgeIdx < indexedNextIdx.size(); edgeIdx++)
+        unindexParent(edgeIdx);
+    for (size_t edgeIdx = numEdges; edgeIdx < firstParentByNext.size(); edgeIdx++)
+        while (firstParentByNext[edgeIdx] != -1)
+            unindexParent(firstParentByNext[edgeIdx]);
+    firstParentByNext.resize(numEdges, -1);
+    nextParentByNext.resize(numEdges, -1);
+    indexedNextIdx.resize(numEdges, -1);
+
+    for (int edgeIdx : dirtyEdges.idxs)
+        if (static_cast<size_t>(edgeIdx) < numEdges)
+            indexParent(mesh, edgeIdx);
+    for (size_t edgeIdx = dirtyEdges.flags.size(); edgeIdx < numEdges; edgeIdx++)
+        indexParent(mesh, edgeIdx);
+}
+
+// Lists the edge under its current next edge if it is a parent
+void PatchCache::indexParent(const GradMesh &mesh, int edgeIdx)
+{
+    unindexParent(edgeIdx);
+    const auto &edge = mesh.getEdges()[edgeIdx];
+    if (!edge.isParent() || edge.nextIdx < 0 || static_cast<size_t>(edge.nextIdx) >= firstParentByNext.size())
+        return;
+    nextParentByNext[edgeIdx] = firstParentByNext[edge.nextIdx];
+    firstParentByNext[edge.nextIdx] = edgeIdx;
+    indexedNextIdx[edgeIdx] = edge.nextIdx;
+}
+
+void PatchCache::unindexParent(int edgeIdx)
+{
+    const int nextIdx = indexedNextIdx[edgeIdx];
+    if (nextIdx == -1)
+        return;
+    int *link = &firstParentByNext[nextIdx];
+    while (*link != edgeIdx)
+        link = &nextParentByNext[*link];
+    *link = nextParentByNext[edgeIdx];
+    nextParentByNext[edgeIdx] = -1;
+    indexedNextIdx[edgeIdx] = -1;
+}
+
+const std::vector<int> &PatchCache::collectDirtyFaces(const GradMesh &mesh)
+{
+    const auto &edges = mesh.getEdges();
+    const auto &faces = mesh.getFaces();
+    const auto &handles = mesh.getHandles();
+    for (int faceIdx : dirtyFaceIdxs)
+        faceSeen[faceIdx] = 0;
+    for (int edgeIdx : seenEdgeIdxs)
+        edgeSeen[edgeIdx] = 0;
+    dirtyFaceIdxs.clear();
+    seenEdgeIdxs.clear();
+    faceSeen.resize(faces.size(), 0);
+    edgeSeen.resize(edges.size(), 0);
+    std::vector<int> edgeStack;
+
+    auto addFace = [&](int faceIdx)
+    {
+        if (faceIdx >= 0 && static_cast<size_t>(faceIdx) < faces.size() && !faceSeen[faceIdx])
+        {
+            faceSeen[faceIdx] = 1;
+            dirtyFaceIdxs.push_back(faceIdx);
+        }
+    };
+    auto addEdge = [&](int edgeIdx)
+    {
+        if (edgeIdx >= 0 && static_cast<size_t>(edgeIdx) < edges.size() && !edgeSeen[edgeIdx])
+        {
+            edgeSeen[edgeIdx] = 1;
+            seenEdgeIdxs.push_back(edgeIdx);
+            edgeStack.push_back(edgeIdx);
+        }
+    };
+
+    for (int faceIdx : dirtyFaces.idxs)
+        addFace(faceIdx);
+    for (size_t faceIdx = dirtyFaces.flags.size(); faceIdx < faces.size(); faceIdx++)
+        addFace(faceIdx);
+    for (int edgeIdx : dirtyEdges.idxs)
+        addEdge(edgeIdx);
+    for (size_t edgeIdx = dirtyEdges.flags.size(); edgeIdx < edges.size(); edgeIdx++)
+        addEdge(edgeIdx);
+    // a handle belongs to the half-edge it stores, new handles are reached through their (new or edited) edge
+    for (int handleIdx : dirtyHandles.idxs)
+        if (static_cast<size_t>(handleIdx) < handles.size())
+            addEdge(handles[handleIdx].halfEdgeIdx);
+
+    while (!edgeStack.empty())
+    {
+        int edgeIdx = edgeStack.back();
+        edgeStack.pop_back();
+        const auto &edge = edges[edgeIdx];
+        addFace(edge.faceIdx);
+        for (int childIdx : mesh.getChildren(edge))
+            addEdge(childIdx);
+        for (int parentIdx = firstParentByNext[edgeIdx]; parentIdx != -1; parentIdx = nextParentByNext[parentIdx])
+            for (int childIdx : mesh.getChildren(parentIdx))
+                addEdge(childIdx);
+    }
+    return dirtyFaceIdxs;
+}
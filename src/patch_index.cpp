@@ -0,0 +1,136 @@
+#include "patch_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+inline constexpr int MAX_INDEX_CELLS_PER_AXIS{256};
+
+void PatchIndex::build(const std::vector<Patch> &patches)
+{
+    clear();
+    indexedPatches = patches.size();
+    if (patches.empty())
+        return;
+
+    for (const auto &patch : patches)
+        bounds.expand(patch.getAABB());
+    // About one patch per cell, the cells follow the aspect ratio of the mesh
+    glm::vec2 extent = glm::max(bounds.max - bounds.min, glm::vec2(1e-6f));
+    float cellEdge = std::sqrt(extent.x * extent.y / patches.size());
+    cellsX = std::clamp(static_cast<int>(std::ceil(extent.x / cellEdge)), 1, MAX_INDEX_CELLS_PER_AXIS);
+    cellsY = std::clamp(static_cast<int>(std::ceil(extent.y / cellEdge)), 1, MAX_INDEX_CELLS_PER_AXIS);
+    cellSize = extent / glm::vec2(cellsX, cellsY);
+
+    // Count, then fill, so each cell's patches are contiguous and sorted by index
+    cellStart.assign(static_cast<size_t>(cellsX) * cellsY + 1, 0);
+    for (const auto &patch : patches)
+    {
+        auto [x0, y0] = cellCoords(patch.getAABB().min);
+        auto [x1, y1] = cellCoords(patch.getAABB().max);
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                cellStart[y * cellsX + x + 1]++;
+    }
+    for (size_t i = 1; i < cellStart.size(); i++)
+        cellStart[i] += cellStart[i - 1];
+
+    cellPatches.resize(cellStart.back());
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < patches.size(); i++)
+    {
+        auto [x0, y0] = cellCoords(patches[i].getAABB().min);
+        auto [x1, y1] = cellCoords(patches[i].getAABB().max);
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                cellPatches[fill[y * cellsX + x]++] = static_cast<int>(i);
+    }
+}
+
+void PatchIndex::clear()
+{
+    bounds = AABB{};
+    cellsX = cellsY = 0;
+    indexedPatches = 0;
+    cellStart.clear();
+    cellPatches.clear();
+}
+
+std::pair<int, int> PatchIndex::cellCoords(glm::vec2 pos) const
+{
+    glm::vec2 cell = (pos - bounds.min) / cellSize;
+    return {std::clamp(static_cast<int>(std::floor(cell.x)), 0, cellsX - 1), std::clamp(static_cast<int>(std::floor(cell.y)), 0, cellsY - 1)};
+}
+
+std::span<const int> PatchIndex::candidates(glm::vec2 pos) const
+{
+    if (cellStart.empty() || !bounds.contains(pos))
+        return {};
+    auto [x, y] = cellCoords(pos);
+    int cell = y * cellsX + x;
+    return {cellPatches.data() + cellStart[cell], cellPatches.data() + cellStart[cell + 1]};
+}
+
+int getSelectedPatch(const std::vector<Patch> &patches, const PatchIndex &index, glm::vec2 pos)
+{
+    if (index.numPatches() != patches.size())
+        return getSelectedPatch(patches, pos);
+
+    double min_dist = 1;
+    int selectedPatchIdx = -1;
+    for (int patchIdx : index.candidates(pos))
+    {
+        if (!patches[patchIdx].contains(pos))
+            continue;
+        double dist = patches[patchIdx].isPointInsidePatch(pos);
+        if (min_dist > dist)
+        {
+            selectedPatchIdx = patchIdx;
+            min_dist = dist;
+        }
+    }
+    return selectedPatchIdx;
+}
+
+void PatchLookup::build(const std::vector<Patch> &patches)
+{
+    facePatches.clear();
+    edgeCurves.clear();
+    for (size_t patchIdx = 0; patchIdx < patches.size(); patchIdx++)
+    {
+        const auto &patch = patches[patchIdx];
+        int faceIdx = patch.getFaceIdx();
+        if (faceIdx >= 0)
+        {
+            if (static_cast<size_t>(faceIdx) >= facePatches.size())
+                facePatches.resize(faceIdx + 1, -1);
+            // the first patch of a face wins, like the scan it replaces
+            if (facePatches[faceIdx] == -1)
+                facePatches[faceIdx] = static_cast<int>(patchIdx);
+        }
+        const auto &curves = patch.getCurves();
+        for (size_t curveIdx = 0; curveIdx < curves.size(); curveIdx++)
+        {
+            int edgeIdx = curves[curveIdx].getHalfEdgeIdx();
+            if (edgeIdx < 0)
+                continue;
+            if (static_cast<size_t>(edgeIdx) >= edgeCurves.size())
+                edgeCurves.resize(edgeIdx + 1, CurveId{-1, -1});
+            if (edgeCurves[edgeIdx].isNull())
+                edgeCurves[edgeIdx] = CurveId{static_cast<int>(patchIdx), static_cast<int>(curveIdx)};
+        }
+    }
+}
+
+int PatchLookup::patchOfFace(int faceIdx) const
+{
+    if (faceIdx < 0 || static_cast<size_t>(faceIdx) >= facePatches.size())
+        return -1;
+    return facePatches[faceIdx];
+}
+
+CurveId PatchLookup::curveOfEdge(int halfEdgeIdx) const
+{
+    if (halfEdgeIdx < 0 || static_cast<size_t>(halfEdgeIdx) >= edgeCurves.size())
+        return CurveId{-1, -1};
+    return edgeCurves[halfEdgeIdx];
+}
@@ -0,0 +1,576 @@
+#include "patch_merger.hpp"
+#include "gms_math.hpp"
+
+#include <iostream>
+
+GmsAppState::MergeStats PatchMerger::merge(int mergeEdgeIdx)
+{
+    GmsAppState::MergeStats stats;
+    auto [face1RIdx, face1BIdx, face1LIdx, face1TIdx] = mesh.getFaceEdgeIdxs(mergeEdgeIdx);
+    auto &face1R = mesh.editEdge(face1RIdx);
+    auto &face1B = mesh.editEdge(face1BIdx);
+    auto &face1L = mesh.editEdge(face1LIdx);
+    auto &face1T = mesh.editEdge(face1TIdx);
+
+    auto [face2LIdx, face2TIdx, face2RIdx, face2BIdx] = mesh.getFaceEdgeIdxs(face1R.twinIdx);
+    auto &face2L = mesh.editEdge(face2LIdx);
+    auto &face2T = mesh.editEdge(face2TIdx);
+    auto &face2R = mesh.editEdge(face2RIdx);
+    auto &face2B = mesh.editEdge(face2BIdx);
+
+    auto *topLeftEdge = &face1T;
+    auto *topRightEdge = &face2T;
+    auto *bottomLeftEdge = &face1B;
+    auto *bottomRightEdge = &face2B;
+    int newTopEdgeIdx = face1TIdx;
+    int newBottomEdgeIdx = face1BIdx;
+
+    bool scaleTopHandles = true;
+    bool scaleBottomHandles = true;
+    bool addTopT = true;
+    bool addBottomT = true;
+
+    bool topLeftL = face1L.isBar() && face1T.isStem();
+    bool topLeftT = face1T.isBar() && (mesh.twinIsStem(face1L) || mesh.twinParentIsStem(face1L));
+    bool topRightT = face2T.isBar() && (face2R.isStem() || mesh.parentIsStem(face2R));
+    bool topRightL = face2R.isBar() && (mesh.twinIsStem(face2T) || mesh.twinParentIsStem(face2T)) && !topRightT;
+    bool topIsStem = face1R.isStem();
+    stats.topEdgeCase = getCornerTJunctions(topLeftL, topLeftT, topRightL, topRightT, topIsStem);
+
+    bool bottomLeftT = (face1L.isStem() || mesh.parentIsStem(face1L)) && face1B.isBar();
+    bool bottomRightL = face2R.isBar() && face2B.isStem();
+    bool bottomRightT = face2B.isBar() && (mesh.twinIsStem(face2R) || mesh.twinParentIsStem(face2R));
+    bool bottomIsStem = face2L.isStem();
+    stats.bottomEdgeCase = getCornerTJunctions(0, bottomLeftT, bottomRightL, bottomRightT, bottomIsStem);
+
+    float topEdgeT = topIsStem ? 0 : splittingFactor(face1R, face1T, face2T, 1);
+    float bottomEdgeT = bottomIsStem ? 0 : splittingFactor(face2L, face1B, face2B, 1);
+    float t = (topIsStem && bottomIsStem) ? 0 : (topEdgeT + bottomEdgeT) / (!topIsStem + !bottomIsStem);
+
+    mesh.disablePoint(face1R);
+    mesh.disablePoint(face1B);
+    mesh.disablePoint(face2T);
+    mesh.disablePoint(face2L);
+
+    switch (stats.topEdgeCase)
+    {
+    case IsStem:
+    {
+        if (face1T.isLeftMostChild() && face2T.isRightMostChild())
+        {
+            childBecomesItsParent(face1TIdx);
+        }
+        else
+        {
+            face1T.interval.y = face2T.interval.y;
+            setNextRightL(face2T, face1RIdx);
+            mesh.removeChild(face1T.parentIdx, face1RIdx);
+            mesh.removeChild(face1T.parentIdx, face2TIdx);
+        }
+        transferChildTo(face2RIdx, face1RIdx);
+        scaleTopHandles = addTopT = 0;
+        break;
+    }
+    case LeftT | RightT:
+    {
+        // 9 --> 18 --> 8
+        newTopEdgeIdx = face1T.parentIdx;
+        topLeftEdge = &mesh.editEdge(newTopEdgeIdx);
+        topRightEdge = &mesh.editEdge(face2T.parentIdx);
+
+        float totalRelativeLeft = totalCurveRelativeLeft((1.0f - t) / t, face1T, face2T);
+        float totalRelativeRight = totalCurveRelativeRight(t / (1.0f - t), face2T, face1T);
+        topEdgeT = 1.0f / totalRelativeLeft;
+
+        rightTUpdateInterval(face2T.parentIdx, totalRelativeRight - 1.0f, totalRelativeRight);
+        leftTUpdateInterval(newTopEdgeIdx, totalRelativeLeft);
+        setChildrenNewParent(*topRightEdge, newTopEdgeIdx);
+
+        // left T inherits the children from right T
+        mesh.replaceChild(face2T.parentIdx, face2TIdx, face1TIdx);
+        mesh.replaceChild(face2T.parentIdx, face2RIdx, face1RIdx);
+        mesh.addChildren(newTopEdgeIdx, mesh.getChildren(*topRightEdge));
+        topLeftEdge->nextIdx = topRightEdge->nextIdx;
+
+        face1R.createStem(newTopEdgeIdx, face2R.interval);
+        face1T.interval.y = face2T.interval.y;
+        topRightEdge->disable();
+        break;
+    }
+    case LeftL | RightT:
+        // if top left edge is a stem, turn the parent into that stem
+        // 2 --> 20 --> 7 (no twisting head) or 3 --> 24 --> 36
+        transferChildTo(face1TIdx, face2T.parentIdx);
+        [[fallthrough]];
+    case RightT:
+    {
+        // 41 --> 23
+        // keep the parent, make the top left edge the bar1
+        newTopEdgeIdx = face2T.parentIdx;
+        topRightEdge = &mesh.editEdge(newTopEdgeIdx);
+
+        auto [newCurvePart, totalCurve] = parameterizeTBar2(t / (1.0f - t), face2T);
+        topEdgeT = newCurvePart / totalCurve;
+
+        mesh.editHandle(topRightEdge->handleIdxs.first) = mesh.handles[face1T.handleIdxs.first] * (1.0f / topEdgeT);
+        mesh.editHandle(topRightEdge->handleIdxs.second) *= (1.0f / (1.0f - topEdgeT));
+
+        topRightEdge->copyGeometricData(face1T);
+        face1T.createBar(-1, {0, 1});
+        transferChildToWithoutGeometry(face2TIdx, face1TIdx);
+        rightTUpdateInterval(newTopEdgeIdx, newCurvePart, totalCurve);
+        transferChildTo(face2RIdx, face1RIdx);
+
+        scaleTopHandles = false;
+        break;
+    }
+    case LeftT | RightL:
+        // 9 --> 47 --> 8 or 16 -> 38 --> 26
+        transferChildTo(face2RIdx, face1RIdx);
+        [[fallthrough]];
+    case LeftT:
+    {
+        newTopEdgeIdx = face1T.parentIdx;
+        topLeftEdge = &mesh.editEdge(newTopEdgeIdx);
+
+        auto [_, totalCurve] = parameterizeTBar1((1.0f - t) / t, face1T);
+        topEdgeT = 1.0f / totalCurve;
+
+        leftTUpdateInterval(newTopEdgeIdx, totalCurve);
+        break;
+    }
+    case LeftL | RightL:
+    case RightL:
+    {
+        // for leftL, weird case: basically just delete the stem from the RightL
+        // 2 --> 49 --> 7 or 18 --> 35 --> 16
+        transferChildToWithoutGeometry(face2RIdx, face1RIdx);
+        break;
+    }
+    default:
+    {
+        break;
+    }
+    }
+
+    switch (stats.bottomEdgeCase)
+    {
+    case IsStem:
+    {
+        if (face2B.isLeftMostChild() && face1B.isRightMostChild())
+        {
+            childBecomesItsParent(face1BIdx);
+        }
+        else
+        {
+            face1B.interval.x = face2B.interval.x;
+            face1B.color = face2B.color;
+            mesh.removeChild(face1B.parentIdx, face2BIdx);
+            mesh.removeChild(face1B.parentIdx, face2LIdx);
+        }
+        if (!topIsStem)
+            transferChildTo(face2RIdx, face1RIdx);
+
+        scaleBottomHandles = addBottomT = 0;
+        break;
+    }
+    case LeftT | RightT:
+    {
+        // 0 -> 20 -> 14
+        newBottomEdgeIdx = face1B.parentIdx;
+        bottomLeftEdge = &mesh.editEdge(newBottomEdgeIdx);
+        int rightTParentIdx = face2B.parentIdx;
+        bottomRightEdge = &mesh.editEdge(rightTParentIdx);
+
+        float totalRelativeRight = totalCurveRelativeRight((1.0f - t) / t, face1B, face2B);
+        float totalRelativeLeft = totalCurveRelativeLeft(t / (1.0f - t), face2B, face1B);
+        bottomEdgeT = 1.0f / totalRelativeRight;
+
+        leftTUpdateInterval(rightTParentIdx, totalRelativeLeft);
+        rightTUpdateInterval(newBottomEdgeIdx, totalRelativeRight - 1.0f, totalRelativeRight);
+        setChildrenNewParent(*bottomRightEdge, newBottomEdgeIdx);
+
+        mesh.replaceChild(rightTParentIdx, face2BIdx, face1BIdx);
+        mesh.addChildren(newBottomEdgeIdx, mesh.getChildren(rightTParentIdx));
+
+        face1B.interval.x = face2B.interval.x;
+        face1B.copyGeometricData(face2B);
+        transferChildTo(rightTParentIdx, newBottomEdgeIdx);
+        bottomRightEdge->disable();
+        break;
+    }
+    case RightT:
+    {
+        // 1 -> 31 -> 9 the bottom left edge is not a stem.. its twin is a stem
+        // the bottom left edge inherits the bar data from the bottom right edge
+        newBottomEdgeIdx = face2B.parentIdx;
+        bottomRightEdge = &mesh.editEdge(newBottomEdgeIdx);
+
+        auto [newCurvePart, totalCurve] = parameterizeTBar1(t / (1.0f - t), face2B);
+        bottomEdgeT = newCurvePart / totalCurve;
+
+        mesh.editHandle(bottomRightEdge->handleIdxs.first) *= (1.0f / (1.0f - bottomEdgeT));
+        mesh.editHandle(bottomRightEdge->handleIdxs.second) = mesh.handles[face1B.handleIdxs.second] * (1.0f / bottomEdgeT);
+        bottomRightEdge->nextIdx = face1LIdx; // important !!!
+
+        face1B.createBar(-1, {0, 1});
+        transferChildTo(face2BIdx, face1BIdx);
+
+        leftTUpdateInterval(newBottomEdgeIdx, totalCurve);
+        scaleBottomHandles = false;
+        break;
+    }
+    case LeftT | RightL:
+    {
+        // 1 -> 24 -> 31 or 0 --> 47 --> 14 or 17 --> 37 --> 23
+        transferChildToWithoutGeometry(face2RIdx, face1RIdx);
+        transferChildToWithoutGeometry(face2BIdx, face1B.parentIdx);
+        [[fallthrough]];
+    }
+    case LeftT:
+    {
+        newBottomEdgeIdx = face1B.parentIdx;
+        bottomLeftEdge = &mesh.editEdge(newBottomEdgeIdx);
+
+        float newCurvePart = (1.0f - t) / t * face1B.interval.y;
+        float totalCurve = 1.0f + newCurvePart;
+        bottomEdgeT = 1.0f / totalCurve;
+
+        rightTUpdateInterval(newBottomEdgeIdx, newCurvePart, totalCurve);
+        face1B.interval.x = 0;
+        face1B.color = face2B.color;
+        break;
+    }
+    case RightL:
+    {
+        // with LeftL: 2 --> 49 --> 16
+        transferChildToWithoutGeometry(face2RIdx, face1RIdx);
+        transferChildTo(face2BIdx, face1BIdx);
+        break;
+    }
+    default:
+    {
+        break;
+    }
+    }
+
+    if (scaleTopHandles)
+    {
+        // assert(topLeftEdge->handleIdxs.first != -1 && topLeftEdge->handleIdxs.second != -1);
+        if (topLeftEdge->handleIdxs.first == -1 || topLeftEdge->handleIdxs.second == -1 || topRightEdge->handleIdxs.second == -1)
+        {
+            std::cout << "fail" << stats.topEdgeCase << std::endl;
+            // assert(topRightEdge->handleIdxs.second != -1);
+        }
+        else
+        {
+
+            float topLeftScale = 1.0f / topEdgeT;
+            float topRightScale = 1.0f / (1.0f - topEdgeT);
+            auto &topLeftHandle = mesh.editHandle(topLeftEdge->handleIdxs.first);
+            auto &topRightHandle = mesh.editHandle(topLeftEdge->handleIdxs.second);
+            topLeftHandle *= topLeftScale;
+            topRightHandle = mesh.handles[topRightEdge->handleIdxs.second] * topRightScale;
+            face1R.copyGeometricData(face2R);
+        }
+    }
+
+    if (scaleBottomHandles)
+    {
+        // assert(bottomLeftEdge->handleIdxs.first != -1 && bottomLeftEdge->handleIdxs.second != -1);
+        if (bottomLeftEdge->handleIdxs.first == -1 || bottomLeftEdge->handleIdxs.second == -1 || bottomRightEdge->handleIdxs.second == -1)
+        {
+            std::cout << "fail2" << std::endl;
+        }
+        else
+        {
+
+            float bottomLeftScale = 1.0f / bottomEdgeT;
+            float bottomRightScale = 1.0f / (1.0f - bottomEdgeT);
+            auto &bottomLeftHandle = mesh.editHandle(bottomLeftEdge->handleIdxs.second);
+            auto &bottomRightHandle = mesh.editHandle(bottomLeftEdge->handleIdxs.first);
+            bottomLeftHandle *= bottomLeftScale;
+            bottomRightHandle = mesh.handles[bottomRightEdge->handleIdxs.first] * bottomRightScale;
+            bottomLeftEdge->copyGeometricData(*bottomRightEdge);
+        }
+    }
+
+    face1R.handleIdxs = face2R.handleIdxs;
+    setNextRightL(face2R, face1BIdx);
+
+    // a T-junction can append its parent edge, which invalidates every edge reference held here
+    const int bottomLeftTwinIdx = bottomLeftEdge->twinIdx;
+    const int bottomRightTwinIdx = bottomRightEdge->twinIdx;
+    const int face2Idx = face2L.faceIdx;
+    if (addTopT)
+        addTJunction(topRightEdge->twinIdx, topLeftEdge->twinIdx, newTopEdgeIdx, 1.0f - topEdgeT);
+    if (addBottomT)
+        addTJunction(bottomLeftTwinIdx, bottomRightTwinIdx, newBottomEdgeIdx, bottomEdgeT);
+
+    copyEdgeTwin(face1RIdx, face2RIdx);
+    removeFace(face2Idx);
+
+    stats.mergedHalfEdgeIdx = mergeEdgeIdx;
+    stats.t = t;
+    stats.removedFaceId = face2Idx;
+    stats.topEdgeT = 1.0f - topEdgeT;
+    stats.bottomEdgeT = bottomEdgeT;
+    return stats;
+}
+
+float PatchMerger::splittingFactor(HalfEdge &stem, HalfEdge &bar1, HalfEdge &bar2, int sign) const
+{
+    auto left = mesh.computeEdgeDerivatives(bar1);
+    auto right = mesh.computeEdgeDerivatives(bar2);
+    assert(left && right);
+    const auto &leftPv01 = left.value()[2].coords;   // left patch: P_v(0,1)
+    const auto &rightPv00 = right.value()[1].coords; // right patch: P_v(0,0)
+    const auto &leftPuv01 = stem.twist.coords;       // left patch: P_uv(0,1)
+    const auto &rightPuv00 = bar2.twist.coords;      // right patch: P_uv(0,0)
+
+    auto sumPv0 = absSum(leftPv01, rightPv00); // P_v(0,1) + P_v(0,0)
+
+    float r1 = glm::length(leftPv01) / glm::length(sumPv0);
+    float r2 = glm::length(absSum(leftPv01, sign * BCM * leftPuv01)) / glm::length((sumPv0 + sign * BCM * absSum(leftPuv01, rightPuv00)));
+
+    float t = 0.5 * (r1 + r2);
+    // std::cout << "r1: " << r1 << " r2: " << r2 << " t: " << t << "\n";
+    return t;
+}
+
+void PatchMerger::leftTUpdateInterval(int parentIdx, float totalCurve)
+{
+    auto &parentEdge = mesh.editEdge(parentIdx);
+    for (int childIdx : mesh.getChildren(parentEdge))
+    {
+        auto &child = mesh.editEdge(childIdx);
+        if (child.parentIdx != parentIdx)
+            continue; // strong check b/c i wrote some bad code
+
+        if (child.isRightMostChild())
+            child.interval.x /= totalCurve;
+        else
+            child.interval /= totalCurve;
+    }
+}
+
+void PatchMerger::rightTUpdateInterval(int parentIdx, float reparam1, float reparam2)
+{
+    for (int childIdx : mesh.getChildren(parentIdx))
+    {
+        auto &child = mesh.editEdge(childIdx);
+        if (child.parentIdx != parentIdx)
+            continue; // strong check b/c i wrote some bad code
+
+        if (child.isLeftMostChild())
+        {
+            child.interval.y += reparam1;
+            child.interval.y /= reparam2;
+        }
+        else
+        {
+            child.interval += reparam1;
+            child.interval /= reparam2;
+        }
+    }
+}
+
+void PatchMerger::scaleDownChildrenByT(HalfEdge &parentEdge, float t)
+{
+    for (int childIdx : mesh.getChildren(parentEdge))
+        mesh.editEdge(childIdx).interval *= t;
+}
+
+void PatchMerger::scaleUpChildrenByT(HalfEdge &parentEdge, float t)
+{
+    for (int childIdx : mesh.getChildren(parentEdge))
+    {
+        mesh.editEdge(childIdx).interval *= (1 - t);
+        mesh.editEdge(childIdx).interval += t;
+    }
+}
+
+// I always forget how I wrote this function, bar1 and bar2 are the literal bar1 and bar2 of the new T-junction. That is the order.
+bool PatchMerger::addTJunction(int bar1Idx, int bar2Idx, int twinOfParentIdx, float t)
+{
+    if (bar1Idx == -1 || bar2Idx == -1)
+        return 0;
+
+    auto twinHandles = mesh.editEdge(twinOfParentIdx).handleIdxs;
+    int parentIdx;
+
+    if (mesh.editEdge(bar1Idx).isBar())
+        bar1Idx = mesh.editEdge(bar1Idx).parentIdx; // this is me being bad, the twin isn't updated to the parentIdx like it should be so I have to do a manual check
+
+    if (mesh.editEdge(bar2Idx).isBar())
+        bar2Idx = mesh.editEdge(bar2Idx).parentIdx; // same here
+
+    int stemIdx = mesh.editEdge(bar1Idx).nextIdx;
+    if (mesh.editEdge(mesh.editEdge(bar1Idx).nextIdx).isBar())
+    {
+        stemIdx = mesh.editEdge(mesh.editEdge(bar1Idx).nextIdx).parentIdx;
+    }
+
+    if (mesh.editEdge(bar2Idx).isParent() && mesh.editEdge(bar1Idx).isParent())
+    {
+        // strategy: remove the parent of bar2 and update bar1
+        parentIdx = bar1Idx;
+        scaleDownChildrenByT(mesh.editEdge(bar1Idx), t);
+        scaleUpChildrenByT(mesh.editEdge(bar2Idx), t);
+        mesh.addChildren(bar1Idx, mesh.getChildren(bar2Idx));
+        setChildrenNewParent(mesh.editEdge(bar2Idx), parentIdx);
+        mesh.editEdge(bar2Idx).disable();
+    }
+    else if (mesh.editEdge(bar1Idx).isParent())
+    {
+        parentIdx = bar1Idx;
+        scaleDownChildrenByT(mesh.editEdge(bar1Idx), t);
+        mesh.addChildren(bar1Idx, {bar2Idx});
+        mesh.editEdge(bar2Idx).createBar(parentIdx, {t, 1});
+    }
+    else if (mesh.editEdge(bar2Idx).isParent())
+    {
+        parentIdx = bar2Idx;
+        scaleUpChildrenByT(mesh.editEdge(bar2Idx), t);
+        mesh.addChildren(bar2Idx, {bar1Idx});
+    }
+    else
+    {
+        parentIdx = mesh.addEdge(HalfEdge{});
+        mesh.setChildren(parentIdx, {bar1Idx, bar2Idx});
+        mesh.editEdge(bar2Idx).createBar(parentIdx, {t, 1});
+    }
+
+    if (!mesh.editEdge(bar1Idx).isParent())
+    {
+        if (mesh.editEdge(bar1Idx).isStem())
+        {
+            // 11 --> 40 -- > 23
+            transferChildTo(bar1Idx, parentIdx);
+            mesh.editEdge(parentIdx).handleIdxs = mesh.editEdge(bar1Idx).handleIdxs;
+        }
+        mesh.editEdge(parentIdx).copyGeometricData(mesh.editEdge(bar1Idx));
+        mesh.editEdge(bar1Idx).createBar(parentIdx, {0, t});
+    }
+
+    mesh.editEdge(stemIdx).createStem(parentIdx, {t, t});
+
+    mesh.editEdge(parentIdx).handleIdxs = {twinHandles.second, twinHandles.first};
+    mesh.editEdge(parentIdx).twinIdx = twinOfParentIdx;
+    mesh.editEdge(parentIdx).nextIdx = mesh.editEdge(bar2Idx).nextIdx;
+    mesh.addChildren(parentIdx, {stemIdx});
+    setBarChildrensTwin(mesh.editEdge(parentIdx), twinOfParentIdx);
+
+    // mesh.editEdge(twinOfParentIdx).twinIdx = parentIdx;
+    setParentChildrenTwin(mesh.editEdge(twinOfParentIdx), parentIdx);
+
+    return 1;
+}
+
+void PatchMerger::setChildrenNewParent(HalfEdge &parentEdge, int newParentIdx)
+{
+    for (int childIdx : mesh.getChildren(parentEdge))
+        mesh.editEdge(childIdx).parentIdx = newParentIdx;
+}
+
+void PatchMerger::setParentChildrenTwin(HalfEdge &parentEdge, int newTwinIdx)
+{
+    if (parentEdge.twinIdx == -1 || newTwinIdx == -1)
+        return;
+    parentEdge.twinIdx = newTwinIdx;
+
+    for (int childIdx : mesh.getChildren(parentEdge))
+        if (mesh.editEdge(childIdx).isBar())
+            mesh.editEdge(childIdx).twinIdx = newTwinIdx;
+}
+
+void PatchMerger::setBarChildrensTwin(HalfEdge &parentEdge, int twinIdx)
+{
+    for (int childIdx : mesh.getChildren(parentEdge))
+        if (mesh.editEdge(childIdx).isBar())
+            mesh.editEdge(childIdx).twinIdx = twinIdx;
+}
+
+void PatchMerger::childBecomesItsParent(int childIdx)
+{
+    auto &child = mesh.editEdge(childIdx);
+    int parentIdx = child.parentIdx;
+    fixAndSetTwin(childIdx);
+    transferChildTo(parentIdx, childIdx);
+    child.handleIdxs = mesh.editEdge(parentIdx).handleIdxs;
+    mesh.editEdge(parentIdx).disable();
+}
+
+void PatchMerger::setNextRightL(const HalfEdge &bar, int nextIdx)
+{
+    if (bar.isRightMostChild())
+        mesh.editEdge(bar.parentIdx).nextIdx = nextIdx;
+}
+
+void PatchMerger::transferChildTo(int oldChildIdx, int newChildIdx)
+{
+    mesh.editEdge(newChildIdx).copyGeometricData(mesh.editEdge(oldChildIdx));
+    transferChildToWithoutGeometry(oldChildIdx, newChildIdx);
+}
+
+void PatchMerger::transferChildToWithoutGeometry(int oldChildIdx, int newChildIdx)
+{
+    auto &oldChild = mesh.editEdge(oldChildIdx);
+    auto &newChild = mesh.editEdge(newChildIdx);
+    newChild.copyChildData(oldChild);
+    if (oldChild.parentIdx != -1)
+        mesh.replaceChild(oldChild.parentIdx, oldChildIdx, newChildIdx);
+}
+
+void PatchMerger::fixAndSetTwin(int barIdx)
+{
+    auto &bar = mesh.editEdge(barIdx);
+    // std::cout << "parent is: " << bar.parentIdx;
+    auto &parent = mesh.editEdge(bar.parentIdx);
+    auto &twin = mesh.editEdge(parent.twinIdx);
+    if (bar.twinIdx != parent.twinIdx)
+    {
+        // std::cout << "fixing the twin: prev: " << bar.twinIdx << " new: " << parent.twinIdx << "\n";
+        bar.twinIdx = parent.twinIdx;
+    }
+
+    twin.twinIdx = barIdx;
+    // std::cout << "setting " << bar.twinIdx << " to " << mesh.editEdge(bar.twinIdx).twinIdx << ".\n";
+}
+
+void PatchMerger::copyEdgeTwin(int e1Idx, int e2Idx)
+{
+    auto &e1 = mesh.editEdge(e1Idx);
+    auto &e2 = mesh.editEdge(e2Idx);
+    e1.twinIdx = e2.twinIdx;
+    // don't set the twin if edge2 is a bar b/c it should point to the parent
+    if (e2.hasTwin() && !e2.isBar())
+    {
+        auto &twin = mesh.editEdge(e2.twinIdx);
+        if (twin.isParent())
+        {
+            for (int childIdx : mesh.getChildren(twin))
+            {
+                if (mesh.editEdge(childIdx).isBar())
+                    mesh.editEdge(childIdx).twinIdx = e1Idx;
+            }
+        }
+        twin.twinIdx = e1Idx;
+    }
+}
+
+void PatchMerger::removeFace(int faceIdx)
+{
+    auto &face = mesh.editFace(faceIdx);
+    auto &e1 = mesh.editEdge(face.halfEdgeIdx);
+    auto &e2 = mesh.editEdge(e1.nextIdx);
+    auto &e3 = mesh.editEdge(e2.nextIdx);
+    auto &e4 = mesh.editEdge(e3.nextIdx);
+    if (e1.handleIdxs.first != -1)
+        mesh.editHandle(e1.handleIdxs.first).halfEdgeIdx = mesh.editHandle(e1.handleIdxs.second).halfEdgeIdx = -1;
+    if (e3.handleIdxs.first != -1)
+        mesh.editHandle(e3.handleIdxs.first).halfEdgeIdx = mesh.editHandle(e3.handleIdxs.second).halfEdgeIdx = -1;
+    if (e4.handleIdxs.first != -1)
+        mesh.editHandle(e4.handleIdxs.first).halfEdgeIdx = mesh.editHandle(e4.handleIdxs.second).halfEdgeIdx = -1;
+    face.halfEdgeIdx = e1.faceIdx = e2.faceIdx = e3.faceIdx = e4.faceIdx = -1;
+}
@@ -0,0 +1,216 @@
+#include "patch_rasterizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <omp.h>
+
+namespace
+{
+    inline constexpr int TESS_VERTS_PER_SIDE{PATCH_TESS_LEVEL + 1};
+    inline constexpr int TESS_VERTS_PER_PATCH{TESS_VERTS_PER_SIDE * TESS_VERTS_PER_SIDE};
+    inline constexpr int RASTER_BAND_HEIGHT{16};
+
+    struct RasterVertex
+    {
+        float x, y; // window coordinates, origin at the bottom left like gl_FragCoord
+        float r, g, b;
+    };
+
+    struct TessellatedPatch
+    {
+        int firstVertex;
+        float minY, maxY;
+    };
+
+    // getBlendingFunction in patch.tes.glsl
+    std::array<float, 4> hermiteBlending(float t)
+    {
+        float t2 = t * t;
+        float H0 = (1.0f + 2.0f * t) * (1.0f - t) * (1.0f - t);
+        float H1 = t * (1.0f - t) * (1.0f - t);
+        float H2 = t2 * (t - 1.0f);
+        float H3 = t2 * (3.0f - 2.0f * t);
+        return {H0, H1, H2, H3};
+    }
+
+    // Evaluates the patch on the same uniform grid as the quad tessellator and maps the positions to window coordinates
+    TessellatedPatch tessellatePatch(const float *patchData, const AABB &aabb, int width, int height, RasterVertex *out, int firstVertex)
+    {
+        const float scaleX = width / aabb.width();
+        const float scaleY = height / aabb.length();
+        TessellatedPatch tp{firstVertex, std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()};
+        for (int vi = 0; vi < TESS_VERTS_PER_SIDE; vi++)
+        {
+            auto vH = hermiteBlending(static_cast<float>(vi) / PATCH_TESS_LEVEL);
+            for (int ui = 0; ui < TESS_VERTS_PER_SIDE; ui++)
+            {
+                auto uH = hermiteBlending(static_cast<float>(ui) / PATCH_TESS_LEVEL);
+                // position = dot(vH, M * uH) where column i of M holds control points 4i..4i+3
+                float attribs[GL_FLOATS_PER_VERTEX] = {};
+                for (int i = 0; i < 4; i++)
+                {
+                    for (int j = 0; j < 4; j++)
+                    {
+                        const float w = uH[i] * vH[j];
+                        const float *vert = patchData + (i * 4 + j) * GL_FLOATS_PER_VERTEX;
+                        for (int a = 0; a < GL_FLOATS_PER_VERTEX; a++)
+                            attribs[a] += w * vert[a];
+                    }
+                }
+                RasterVertex &rv = out[vi * TESS_VERTS_PER_SIDE + ui];
+                rv.x = (attribs[0] - aabb.min.x) * scaleX;
+                rv.y = (attribs[1] - aabb.min.y) * scaleY;
+                rv.r = attribs[2];
+                rv.g = attribs[3];
+                rv.b = attribs[4];
+                tp.minY = std::min(tp.minY, rv.y);
+                tp.maxY = std::max(tp.maxY, rv.y);
+            }
+        }
+        return tp;
+    }
+
+    float edgeFunction(const RasterVertex &a, const RasterVertex &b, float px, float py)
+    {
+        return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+    }
+
+    // Tie breaking for pixel centres exactly on an edge, so a pixel on an edge shared by two triangles is drawn once
+    bool ownsEdge(const RasterVertex &a, const RasterVertex &b)
+    {
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        return dy > 0.0f || (dy == 0.0f && dx < 0.0f);
+    }
+
+    uint8_t toUnorm8(float c)
+    {
+        return static_cast<uint8_t>(std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f));
+    }
+
+    void rasterizeTriangle(const RasterVertex &v0, const RasterVertex &v1In, const RasterVertex &v2In,
+                           int width, int rowBegin, int rowEnd, Image &image)
+    {
+        const RasterVertex *v1 = &v1In;
+        const RasterVertex *v2 = &v2In;
+        float area = edgeFunction(v0, *v1, v2->x, v2->y);
+        if (area == 0.0f)
+            return;
+        if (area < 0.0f)
+        {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        float minX = std::min({v0.x, v1->x, v2->x});
+        float maxX = std::max({v0.x, v1->x, v2->x});
+        float minY = std::min({v0.y, v1->y, v2->y});
+        float maxY = std::max({v0.y, v1->y, v2->y});
+        int xBegin = std::max(0, static_cast<int>(std::ceil(minX - 0.5f)));
+        int xEnd = std::min(width - 1, static_cast<int>(std::floor(maxX - 0.5f)));
+        int yBegin = std::max(rowBegin, static_cast<int>(std::ceil(minY - 0.5f)));
+        int yEnd = std::min(rowEnd - 1, static_cast<int>(std::floor(maxY - 0.5f)));
+
+        const bool owns0 = ownsEdge(*v1, *v2);
+        const bool owns1 = ownsEdge(*v2, v0);
+        const bool owns2 = ownsEdge(v0, *v1);
+        const float invArea = 1.0f / area;
+        for (int py = yBegin; py <= yEnd; py++)
+        {
+            uint8_t *row = image.pixels.data() + static_cast<size_t>(py) * width * 3;
+            const float cy = py + 0.5f;
+            for (int px = xBegin; px <= xEnd; px++)
+            {
+                const float cx = px + 0.5f;
+                float w0 = edgeFunction(*v1, *v2, cx, cy);
+                float w1 = edgeFunction(*v2, v0, cx, cy);
+                float w2 = edgeFunction(v0, *v1, cx, cy);
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                    continue;
+                if ((w0 == 0.0f && !owns0) || (w1 == 0.0f && !owns1) || (w2 == 0.0f && !owns2))
+                    continue;
+
+                w0 *= invArea;
+                w1 *= invArea;
+                w2 *= invArea;
+                uint8_t *pixel = row + px * 3;
+                pixel[0] = toUnorm8(w0 * v0.r + w1 * v1->r + w2 * v2->r);
+                pixel[1] = toUnorm8(w0 * v0.g + w1 * v1->g + w2 * v2->g);
+                pixel[2] = toUnorm8(w0 * v0.b + w1 * v1->b + w2 * v2->b);
+            }
+        }
+    }
+}
+
+void rasterizePatches(const std::vector<float> &glPatches, const AABB &aabb, int width, int height, Image &image)
+{
+    image.resize(width, height, 3);
+    std::fill(image.pixels.begin(), image.pixels.end(), 255);
+
+    const int floatsPerPatch = VERTS_PER_PATCH * GL_FLOATS_PER_VERTEX;
+    const int numPatches = static_cast<int>(glPatches.size()) / floatsPerPatch;
+    std::vector<RasterVertex> vertices(static_cast<size_t>(numPatches) * TESS_VERTS_PER_PATCH);
+    std::vector<TessellatedPatch> patches(numPatches);
+
+#pragma omp parallel for
+    for (int p = 0; p < numPatches; p++)
+    {
+        int firstVertex = p * TESS_VERTS_PER_PATCH;
+        patches[p] = tessellatePatch(glPatches.data() + p * floatsPerPatch, aabb, width, height, vertices.data() + firstVertex, firstVertex);
+    }
+
+    // Each thread owns a band of rows and draws every patch in submission order, so overlaps resolve like the GL path
+    const int numBands = (height + RASTER_BAND_HEIGHT - 1) / RASTER_BAND_HEIGHT;
+#pragma omp parallel for schedule(dynamic)
+    for (int band = 0; band < numBands; band++)
+    {
+        int rowBegin = band * RASTER_BAND_HEIGHT;
+        int rowEnd = std::min(height, rowBegin + RASTER_BAND_HEIGHT);
+        for (const auto &patch : patches)
+        {
+            if (patch.maxY < rowBegin || patch.minY > rowEnd)
+                continue;
+
+            const RasterVertex *grid = vertices.data() + patch.firstVertex;
+            for (int vi = 0; vi < PATCH_TESS_LEVEL; vi++)
+            {
+                for (int ui = 0; ui < PATCH_TESS_LEVEL; ui++)
+                {
+                    const RasterVertex &v00 = grid[vi * TESS_VERTS_PER_SIDE + ui];
+                    const RasterVertex &v10 = grid[vi * TESS_VERTS_PER_SIDE + ui + 1];
+                    const RasterVertex &v01 = grid[(vi + 1) * TESS_VERTS_PER_SIDE + ui];
+                    const RasterVertex &v11 = grid[(vi + 1) * TESS_VERTS_PER_SIDE + ui + 1];
+                    rasterizeTriangle(v00, v10, v11, width, rowBegin, rowEnd, image);
+                    rasterizeTriangle(v00, v11, v01, width, rowBegin, rowEnd, image);
+                }
+            }
+        }
+    }
+}
+
+ImageDifference compareImages(const ImageView &img1, const ImageView &img2, int tolerance)
+{
+    ImageDifference diff;
+    if (!img1.sameShape(img2))
+    {
+        diff.differingPixels = -1;
+        return diff;
+    }
+    const size_t numPixels = static_cast<size_t>(img1.width) * img1.height;
+    for (size_t i = 0; i < numPixels; i++)
+    {
+        int maxDiff = 0;
+        for (int c = 0; c < img1.channels; c++)
+        {
+            size_t idx = i * img1.channels + c;
+            maxDiff = std::max(maxDiff, std::abs(img1.data[idx] - img2.data[idx]));
+        }
+        if (maxDiff > tolerance)
+            diff.differingPixels++;
+        diff.maxChannelDifference = std::max(diff.maxChannelDifference, maxDiff);
+    }
+    return diff;
+}
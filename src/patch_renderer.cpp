@@ -138,7 +138,7 @@ void PatchRenderer::updatePatches(std::vector<Patch> &patches)
     glm::mat4 inverseProjectionMatrix = glm::inverse(projectionMatrix);
     glm::vec4 transformedPoint = inverseProjectionMatrix * glm::vec4{GmsWindow::mousePos, 0.0f, 1.0f};
     int prevPatchId = appState.userSelectedId.patchId;
-    int newPatchId = getSelectedPatch(patches, transformedPoint);
+    int newPatchId = getSelectedPatch(patches, appState.patchIndex, transformedPoint);
     appState.setPatchId(newPatchId);
     if (appState.userSelectedId.patchId == -1 || (appState.componentSelectOptions.type == ComponentSelectOptions::Type::Patch && !appState.manualEdgeSelect))
         return; // only selected patch was modified (not curve)
@@ -0,0 +1,94 @@
+#include "patch_vertex_buffer.hpp"
+#include "gradmesh.hpp"
+#include "patch_rasterizer.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    inline constexpr size_t FLOATS_PER_SLOT{VERTS_PER_PATCH * GL_FLOATS_PER_VERTEX};
+}
+
+PatchVertexBuffer::~PatchVertexBuffer()
+{
+    if (vbo != 0)
+        glDeleteBuffers(1, &vbo);
+}
+
+bool PatchVertexBuffer::update(const GradMesh &mesh)
+{
+    bool valid = mesh.updatePatchCache();
+    const auto &facePatches = mesh.getPatchCache().getFacePatches();
+    const auto &faceVersions = mesh.getPatchCache().getFaceVersions();
+
+    // faces are only ever appended, a rollback past an addFace shrinks the mesh and drops the trailing slots
+    data.resize(facePatches.size() * FLOATS_PER_SLOT, 0.0f);
+    slotVersions.resize(facePatches.size(), 0);
+    std::erase_if(dirtySlots, [&](int slot)
+                  { return static_cast<size_t>(slot) >= facePatches.size(); });
+    for (size_t faceIdx = 0; faceIdx < facePatches.size(); faceIdx++)
+    {
+        if (slotVersions[faceIdx] == faceVersions[faceIdx])
+            continue;
+        const auto &patch = facePatches[faceIdx];
+        writeSlot(faceIdx, patch ? &patch.value() : nullptr);
+        slotVersions[faceIdx] = faceVersions[faceIdx];
+    }
+    return valid;
+}
+
+void PatchVertexBuffer::writeSlot(int faceIdx, const Patch *patch)
+{
+    GLfloat *slot = data.data() + faceIdx * FLOATS_PER_SLOT;
+    if (patch)
+    {
+        for (const Vertex &v : patch->getControlMatrix())
+        {
+            *slot++ = v.coords.x;
+            *slot++ = v.coords.y;
+            *slot++ = v.color.r;
+            *slot++ = v.color.g;
+            *slot++ = v.color.b;
+        }
+    }
+    else
+    {
+        std::fill_n(slot, FLOATS_PER_SLOT, 0.0f);
+    }
+    dirtySlots.push_back(faceIdx);
+}
+
+void PatchVertexBuffer::bind()
+{
+    if (vbo == 0)
+        glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    if (uploadedSize != data.size())
+    {
+        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(GLfloat), data.data(), GL_DYNAMIC_DRAW);
+        uploadedSize = data.size();
+    }
+    else
+    {
+        // coalesce neighbouring slots so a merge costs a handful of uploads
+        std::ranges::sort(dirtySlots);
+        auto last = std::unique(dirtySlots.begin(), dirtySlots.end());
+        for (auto it = dirtySlots.begin(); it != last;)
+        {
+            auto runEnd = it + 1;
+            while (runEnd != last && *runEnd == *(runEnd - 1) + 1)
+                ++runEnd;
+            size_t offset = static_cast<size_t>(*it) * FLOATS_PER_SLOT;
+            size_t count = static_cast<size_t>(runEnd - it) * FLOATS_PER_SLOT;
+            glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(GLfloat), count * sizeof(GLfloat), data.data() + offset);
+            it = runEnd;
+        }
+    }
+    dirtySlots.clear();
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, coords));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, color));
+    glEnableVertexAttribArray(1);
+}
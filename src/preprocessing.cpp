@@ -10,61 +10,143 @@
 
 void MergePreprocessor::preprocessSingleMergeError()
 {
-    if (appState.preprocessSingleMergeProgress % 100 == 0 &&
+    // The software rasterizer needs no GL context, so the sweep can run on per-thread mesh copies
+    if (appState.preprocessSingleMergeProgress == 0 && singleMergeWorkers.empty() &&
+        appState.mergeSettings.renderBackend == MergeMetrics::RenderBackend::CPU)
+    {
+        beginSingleMergeSweep();
+        for (int i = 0; i < omp_get_max_threads(); i++)
+            singleMergeWorkers.push_back(std::make_unique<MeshWorker>(mesh));
+    }
+    if (!singleMergeWorkers.empty())
+    {
+        scoreSingleMergesInParallel();
+        return;
+    }
+
+    if (appState.preprocessSingleMergeProgress % SINGLE_MERGE_BATCH_SIZE == 0 &&
         appState.preprocessSingleMergeProgress != 0)
     {
-        int start = appState.preprocessSingleMergeProgress - 100;
+        int start = appState.preprocessSingleMergeProgress - SINGLE_MERGE_BATCH_SIZE;
 #pragma omp parallel for
         for (int i = start; i < appState.preprocessSingleMergeProgress; ++i)
         {
             auto &dhe = appState.candidateMerges[i];
-            std::string imgPath = "preprocessing/e" + std::to_string(i) + ".png";
-            dhe.error = merger.metrics.evaluateMetric(imgPath.c_str());
+            const auto &image = candidateImages[i - start];
+            dhe.error = image.empty() ? 1.0f : scoreSingleMerge(metricContexts[omp_get_thread_num()], image.view(), i);
         }
-        createDir(PREPROCESSING_DIR);
     }
 
     if (appState.preprocessSingleMergeProgress >= appState.candidateMerges.size())
     {
-        int start = appState.preprocessSingleMergeProgress / 100 * 100;
+        int start = appState.preprocessSingleMergeProgress / SINGLE_MERGE_BATCH_SIZE * SINGLE_MERGE_BATCH_SIZE;
 #pragma omp parallel for
         for (int i = start; i < appState.candidateMerges.size(); ++i)
         {
             auto &dhe = appState.candidateMerges[i];
-            std::string imgPath = "preprocessing/e" + std::to_string(i) + ".png";
-            dhe.error = merger.metrics.evaluateMetric(imgPath.c_str());
+            const auto &image = candidateImages[i - start];
+            dhe.error = image.empty() ? 1.0f : scoreSingleMerge(metricContexts[omp_get_thread_num()], image.view(), i);
         }
-        appState.mergeProcess = MergeProcess::Merging;
-        appState.preprocessSingleMergeProgress = -2;
-        merger.metrics.setEdgeErrorMap(appState.candidateMerges);
-        printElapsedTime(appState.startTime);
+        endSingleMergeSweep();
         return;
     }
 
     if (appState.preprocessSingleMergeProgress == 0)
     {
-        std::vector<SingleHalfEdge> boundaryEdges;
-        merger.select.findCandidateMerges(&boundaryEdges);
-        merger.metrics.setBoundaryEdges(boundaryEdges);
-        appState.startTime = std::chrono::high_resolution_clock::now();
-        // merger.metrics.captureBeforeMerge(appState.originalGlPatches);
+        beginSingleMergeSweep();
+        candidateImages.resize(SINGLE_MERGE_BATCH_SIZE);
+        metricContexts.resize(omp_get_max_threads());
     }
 
     auto &dhe = appState.candidateMerges[appState.preprocessSingleMergeProgress];
     int selectedHalfEdgeIdx = dhe.halfEdgeIdx1;
 
+    mesh.beginTransaction();
     merger.mergePatches(selectedHalfEdgeIdx);
-    auto glPatches = getAllPatchGLData(mesh.generatePatches().value(), &Patch::getControlMatrix);
-    std::string imgPath = "preprocessing/e" + std::to_string(appState.preprocessSingleMergeProgress) + ".png";
-    merger.metrics.captureGlobalImage(glPatches, imgPath.c_str());
-    mesh = readHemeshFile("mesh_saves/save_0.hemesh");
+    auto &image = candidateImages[appState.preprocessSingleMergeProgress % SINGLE_MERGE_BATCH_SIZE];
+    if (merger.metrics.updatePatchBuffer())
+    {
+        std::string imgPath = "preprocessing/e" + std::to_string(appState.preprocessSingleMergeProgress) + ".png";
+        merger.metrics.captureGlobalImage(image, imgPath.c_str());
+    }
+    else
+    {
+        image.pixels.clear(); // scored as a failed merge when the batch is evaluated
+    }
+    mesh.rollback();
     appState.preprocessSingleMergeProgress++;
 }
 
+void MergePreprocessor::beginSingleMergeSweep()
+{
+    std::vector<SingleHalfEdge> boundaryEdges;
+    merger.select.findCandidateMerges(&boundaryEdges);
+    merger.metrics.setBoundaryEdges(boundaryEdges);
+    appState.startTime = std::chrono::high_resolution_clock::now();
+    // merger.metrics.captureBeforeMerge(appState.originalGlPatches);
+}
+
+void MergePreprocessor::endSingleMergeSweep()
+{
+    candidateImages.clear();
+    metricContexts.clear();
+    singleMergeWorkers.clear();
+    appState.mergeProcess = MergeProcess::Merging;
+    appState.preprocessSingleMergeProgress = -2;
+    merger.metrics.setEdgeErrorMap(appState.candidateMerges.entries());
+    printElapsedTime(appState.startTime);
+}
+
+// Error maps of parallel evaluations go to a file per candidate
+float MergePreprocessor::scoreSingleMerge(MetricContext &context, const ImageView &image, int candidateIdx) const
+{
+    if (!appState.mergeSettings.writeDebugImages)
+        return merger.metrics.evaluateMetric(context, image);
+    std::string errorMapPath = "preprocessing/errormap_e" + std::to_string(candidateIdx) + ".png";
+    return merger.metrics.evaluateMetric(context, image, errorMapPath.c_str());
+}
+
+// Scores the next batch of candidates per worker. Workers pull candidate indices from a shared counter, merge on their
+// own mesh copy, roll it back and write the error straight into the candidate.
+void MergePreprocessor::scoreSingleMergesInParallel()
+{
+    const int numCandidates = appState.candidateMerges.size();
+    const int begin = appState.preprocessSingleMergeProgress;
+    const int end = std::min(numCandidates, begin + SINGLE_MERGE_BATCH_SIZE * static_cast<int>(singleMergeWorkers.size()));
+    std::atomic<int> nextIdx{begin};
+
+#pragma omp parallel num_threads(singleMergeWorkers.size())
+    {
+        auto &worker = *singleMergeWorkers[omp_get_thread_num()];
+        for (int i = nextIdx++; i < end; i = nextIdx++)
+        {
+            auto &dhe = appState.candidateMerges[i];
+            worker.mesh.beginTransaction();
+            PatchMerger{worker.mesh}.merge(dhe.halfEdgeIdx1);
+            if (worker.patchBuffer.update(worker.mesh))
+            {
+                merger.metrics.rasterizeGlobalImage(worker.patchBuffer.getData(), worker.image);
+                if (appState.mergeSettings.writeDebugImages)
+                    writeImagePNG(worker.image.view(), ("preprocessing/e" + std::to_string(i) + ".png").c_str());
+                dhe.error = scoreSingleMerge(worker.metricContext, worker.image.view(), i);
+            }
+            else
+            {
+                dhe.error = 1.0f;
+            }
+            worker.mesh.rollback();
+        }
+    }
+
+    appState.preprocessSingleMergeProgress = end;
+    if (end >= numCandidates)
+        endSingleMergeSweep();
+}
+
 void MergePreprocessor::mergeMotorcycle()
 {
     appState.startTime = std::chrono::high_resolution_clock::now();
-    mesh = readHemeshFile("mesh_saves/save_0.hemesh");
+    mesh = appState.originalMesh;
     auto mergeableRegions = merger.metrics.getMergeableRegions();
     for (auto &mr : mergeableRegions)
     {
@@ -83,18 +165,17 @@ void MergePreprocessor::mergeMotorcycle()
         if (region.maxRegion.first == 0 && region.maxRegion.second == 0)
             continue;
 
-        writeHemeshFile("mesh_saves/lastsave.hemesh", mesh);
+        mesh.beginTransaction();
         mergeEdgeRegionWithError({region.gridPair, region.maxRegion});
-        if (!mesh.generatePatches())
-        {
-            mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
-        }
+        if (mesh.updatePatchCache())
+            mesh.commit();
+        else
+            mesh.rollback();
     }
 
     appState.regionsMerged = mergeableRegions.size();
     appState.updateMeshRender();
-    merger.metrics.captureGlobalImage(appState.patchRenderParams.glPatches, CURR_IMG);
-    appState.mergeError = merger.metrics.evaluateMetric(CURR_IMG, ORIG_IMG);
+    appState.mergeError = merger.metrics.getGlobalError(appState.patchRenderParams.glPatches);
     appState.mergeProcess = MergeProcess::Merging;
 
     auto end = std::chrono::high_resolution_clock::now();
@@ -105,112 +186,202 @@ void MergePreprocessor::mergeMotorcycle()
 
 void MergePreprocessor::preprocessProductRegions()
 {
+    if (appState.cancelRequested)
+    {
+        cancelProductRegionSweep();
+        return;
+    }
+
     if (productRegionIdx == 0)
+    {
         appState.startTime = std::chrono::high_resolution_clock::now();
+        mesh = appState.originalMesh;
+        // Every edge region starts from the original mesh, so with the software rasterizer they can be searched on
+        // per-thread mesh copies
+        if (appState.mergeSettings.renderBackend == MergeMetrics::RenderBackend::CPU)
+            for (int i = 0; i < omp_get_max_threads(); i++)
+                productRegionWorkers.push_back(std::make_unique<MeshWorker>(mesh));
+    }
 
-    // auto &edgeRegions = appState.edgeRegions;
-    auto &currEdgeRegion = edgeRegions[productRegionIdx++];
-
-    auto allRegions = findMaxProductRegion(currEdgeRegion);
-    mesh = readHemeshFile("mesh_saves/save_0.hemesh");
-    if (!allRegions.empty())
+    if (!productRegionWorkers.empty())
     {
-        for (auto &region : allRegions)
+        findProductRegionsInParallel();
+    }
+    else
+    {
+        // auto &edgeRegions = appState.edgeRegions;
+        auto &currEdgeRegion = edgeRegions[productRegionIdx++];
+
+        // leaves the mesh unmerged
+        auto allRegions = findMaxProductRegion(currEdgeRegion);
+        if (!allRegions.empty())
         {
-            // region.maxRegionAABB = mesh.getProductRegionAABB(currEdgeRegion.gridPair, region.maxRegion);
+            for (auto &region : allRegions)
+            {
+                // region.maxRegionAABB = mesh.getProductRegionAABB(currEdgeRegion.gridPair, region.maxRegion);
+            }
+            currEdgeRegion.setAndSortAttributes(allRegions);
         }
-        currEdgeRegion.setAndSortAttributes(allRegions);
     }
 
     appState.preprocessProductRegionsProgress = static_cast<float>(productRegionIdx) / edgeRegions.size();
 
     if (productRegionIdx >= edgeRegions.size())
-    {
-        createAdjList();
-        computeConflictGraphStats();
-        appState.mergeProcess = MergeProcess::Merging;
-        appState.preprocessProductRegionsProgress = -2.0f;
-        productRegionIdx = 0;
-        saveConflictGraphToFile(std::string{TPR_PREPROCESSING_DIR} + "/" + appState.meshname + ".txt", allTPRs, adjList, edgeRegions);
+        endProductRegionSweep();
+}
 
-        printElapsedTime(appState.startTime);
+// Searches the next batch of edge regions. Workers pull edge region indices from a shared counter and leave their mesh
+// copy unmerged, like findMaxProductRegion leaves the app mesh.
+void MergePreprocessor::findProductRegionsInParallel()
+{
+    const int numRegions = edgeRegions.size();
+    const int begin = productRegionIdx;
+    const int end = std::min(numRegions, begin + PRODUCT_REGION_BATCH_SIZE * static_cast<int>(productRegionWorkers.size()));
+    std::atomic<int> nextIdx{begin};
+
+#pragma omp parallel num_threads(productRegionWorkers.size())
+    {
+        auto &worker = *productRegionWorkers[omp_get_thread_num()];
+        for (int i = nextIdx++; i < end; i = nextIdx++)
+        {
+            auto allRegions = findMaxProductRegion(edgeRegions[i], &worker);
+            if (!allRegions.empty())
+                edgeRegions[i].setAndSortAttributes(allRegions);
+        }
     }
+
+    productRegionIdx = end;
+}
+
+void MergePreprocessor::endProductRegionSweep()
+{
+    productRegionWorkers.clear();
+    createAdjList();
+    computeConflictGraphStats();
+    appState.mergeProcess = MergeProcess::Merging;
+    appState.preprocessProductRegionsProgress = -2.0f;
+    productRegionIdx = 0;
+    saveConflictGraphToFile(std::string{TPR_PREPROCESSING_DIR} + "/" + appState.meshname + std::string{TPRB_EXTENSION}, allTPRs, adjList, edgeRegions);
+
+    printElapsedTime(appState.startTime);
+}
+
+// Drops the regions found so far, the preprocessing can be started again
+void MergePreprocessor::cancelProductRegionSweep()
+{
+    appState.cancelRequested = false;
+    productRegionWorkers.clear();
+    for (auto &edgeRegion : edgeRegions)
+        edgeRegion.allRegionAttributes.clear();
+    productRegionIdx = 0;
+    mesh = appState.originalMesh;
+    appState.mergeProcess = MergeProcess::Merging;
+    appState.preprocessProductRegionsProgress = -1.0f;
+    appState.startTime.reset();
 }
 
 void MergePreprocessor::loadProductRegionsPreprocessing()
 {
     appState.mergeProcess = MergeProcess::Merging;
-    loadConflictGraphFromFile(appState.loadPreprocessingFilename, allTPRs, adjList, edgeRegions);
+    // regions preprocessed before the binary format are still in the text file
+    std::filesystem::path filename{appState.loadPreprocessingFilename};
+    if (!std::filesystem::exists(filename) && isConflictGraphBinaryFile(filename.string()) && std::filesystem::exists(std::filesystem::path{filename}.replace_extension(".txt")))
+        filename.replace_extension(".txt");
+    if (!loadConflictGraphFromFile(filename.string(), allTPRs, adjList, edgeRegions))
+        return;
     // createAdjList();
     computeConflictGraphStats();
     appState.preprocessProductRegionsProgress = -2.0f;
     productRegionIdx = 0;
 }
 
-std::vector<RegionAttributes> MergePreprocessor::mergeRow(int currEdgeIdx, AABB &aabb, bool isRow, int maxLength, int oppLength)
+// GradMeshMerger::attemptMerge on the worker's mesh copy, rendered by the software rasterizer
+float MergePreprocessor::attemptMerge(MeshWorker *worker, int currEdgeIdx, AABB &aabb)
+{
+    if (!worker)
+        return merger.attemptMerge(currEdgeIdx, aabb);
+
+    merger.metrics.rasterizeBeforeMerge(appState.originalGlPatches, aabb, worker->previous);
+    PatchMerger{worker->mesh}.merge(currEdgeIdx);
+    if (!worker->patchBuffer.update(worker->mesh))
+        return 1.0f;
+    return merger.metrics.rasterizeMergeError(worker->metricContext, worker->globalSSIM, worker->patchBuffer.getData(), aabb, worker->previous, worker->image);
+}
+
+std::vector<RegionAttributes> MergePreprocessor::mergeRow(MeshWorker *worker, int currEdgeIdx, AABB &aabb, bool isRow, int maxLength, int oppLength)
 {
+    GradMesh &target = worker ? worker->mesh : mesh;
     std::vector<RegionAttributes> mergeRowList;
     int length = 0;
     for (length; length < maxLength; length++)
     {
-        auto &currEdge = mesh.edges[currEdgeIdx];
-        if (!mesh.validMergeEdge(currEdge))
+        auto &currEdge = target.edges[currEdgeIdx];
+        if (!target.validMergeEdge(currEdge))
             break;
 
         if (appState.mergeSettings.pixelRegion == MergeMetrics::PixelRegion::Local)
         {
-            aabb.expand(mesh.getAffectedMergeAABB(currEdgeIdx));
+            aabb.expand(target.getAffectedMergeAABB(currEdgeIdx));
             aabb.constrain(appState.mergeSettings.globalAABB);
             aabb.ensureSize(MIN_AABB_SIZE);
         }
 
-        float mergeError = merger.attemptMerge(currEdgeIdx, aabb);
+        target.beginTransaction();
+        float mergeError = attemptMerge(worker, currEdgeIdx, aabb);
 
         if (appState.mergeSettings.pixelRegion == MergeMetrics::PixelRegion::Local)
             mergeError *= (aabb.area() / appState.mergeSettings.globalAABB.area());
 
         if (mergeError > appState.mergeSettings.errorThreshold)
+        {
+            // a rejected first merge is kept, findAllRegions relies on it
+            if (length > 0)
+                target.rollback();
+            else
+                target.commit();
             break;
+        }
+        target.commit();
 
         std::pair<int, int> regionPair = isRow ? std::make_pair(length + 1, oppLength) : std::make_pair(oppLength, length + 1);
 
-        mergeRowList.push_back({regionPair, mergeError, mesh.maxDependencyChain()});
-        writeHemeshFile("mesh_saves/lastsave.hemesh", mesh);
+        mergeRowList.push_back({regionPair, mergeError, target.maxDependencyChain()});
     }
-    if (length > 0)
-        mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
 
     return mergeRowList;
 }
 
-int MergePreprocessor::mergeRowWithoutError(int currEdgeIdx, int maxLength)
+int MergePreprocessor::mergeRowWithoutError(GradMesh &target, int currEdgeIdx, int maxLength) const
 {
     int length = 0;
     for (length; length < maxLength; length++)
     {
-        auto &currEdge = mesh.edges[currEdgeIdx];
-        if (!mesh.validMergeEdge(currEdge))
+        auto &currEdge = target.edges[currEdgeIdx];
+        if (!target.validMergeEdge(currEdge))
             break;
-        merger.mergePatches(currEdgeIdx);
+        PatchMerger{target}.merge(currEdgeIdx);
     }
     return length;
 }
 
-std::vector<RegionAttributes> MergePreprocessor::findMaxProductRegion(EdgeRegion &edgeRegion)
+std::vector<RegionAttributes> MergePreprocessor::findMaxProductRegion(EdgeRegion &edgeRegion, MeshWorker *worker)
 {
+    GradMesh &target = worker ? worker->mesh : mesh;
     AABB errorAABB{};
     auto [rowIdx, colIdx] = edgeRegion.gridPair;
     std::vector<RegionAttributes> regionAttributes;
 
-    auto mergedRows = mergeRow(rowIdx, errorAABB);
+    target.beginTransaction();
+    auto mergedRows = mergeRow(worker, rowIdx, errorAABB);
     std::ranges::copy(mergedRows, std::back_inserter(regionAttributes));
     int rowLength = mergedRows.empty() ? 0 : mergedRows.back().maxRegion.first;
-    mesh = readHemeshFile("mesh_saves/save_0.hemesh");
+    target.rollback();
 
-    auto mergedCols = mergeRow(colIdx, errorAABB, false);
+    target.beginTransaction();
+    auto mergedCols = mergeRow(worker, colIdx, errorAABB, false);
     std::ranges::copy(mergedCols, std::back_inserter(regionAttributes));
     int colLength = mergedCols.empty() ? 0 : mergedCols.back().maxRegion.second;
-    mesh = readHemeshFile("mesh_saves/save_0.hemesh");
+    target.rollback();
 
     if (rowLength == 0 || colLength == 0)
         return regionAttributes;
@@ -219,37 +390,73 @@ std::vector<RegionAttributes> MergePreprocessor::findMaxProductRegion(EdgeRegion
     int currRowIdx = rowIdx;
     for (int i = 0; i < colLength; i++)
     {
-        currRowIdx = mesh.getNextRowIdx(currRowIdx);
+        currRowIdx = target.getNextRowIdx(currRowIdx);
         if (currRowIdx == -1)
             break;
         rowIdxs.push_back(currRowIdx);
     }
 
-    findAllRegions(rowIdxs, rowLength, errorAABB, regionAttributes);
+    findAllRegions(worker, rowIdxs, rowLength, errorAABB, regionAttributes);
     return regionAttributes;
 }
 
-void MergePreprocessor::findAllRegions(const std::vector<int> &rowIdxs, int rowLength, AABB &errorAABB, std::vector<RegionAttributes> &regionAttributes)
+// Grows the regions of rows 1, 2, ... cell by cell. Scoring row rowIdx at rowCell cells sees the mesh with only that row
+// merged, so the row is kept merged in a transaction and extended by the one new cell, instead of merging and scoring
+// its rowCell cells again. The earlier rows and the column are merged on top of it and rolled back.
+// A row that stops early stays merged until the next column is rolled back, the first cell of the next row is scored
+// with it, and the row is rebuilt from the unmerged mesh afterwards.
+void MergePreprocessor::findAllRegions(MeshWorker *worker, const std::vector<int> &rowIdxs, int rowLength, AABB &errorAABB, std::vector<RegionAttributes> &regionAttributes)
 {
-    int mergeColIdx = rowIdxs.empty() ? -1 : mesh.edges[rowIdxs[0]].nextIdx;
+    GradMesh &target = worker ? worker->mesh : mesh;
+    int mergeColIdx = rowIdxs.empty() ? -1 : target.edges[rowIdxs[0]].nextIdx;
+    bool stoppedRowMerged = false;
+    target.beginTransaction(); // the row that stopped early
     for (int rowIdx = 1; rowIdx < rowIdxs.size(); rowIdx++)
     {
         int currEdgeIdx = rowIdxs[rowIdx];
+        int mergedCells = 0;
+        bool rowStopped = false;
+        target.beginTransaction(); // the merged cells of this row
 
         for (int rowCell = 1; rowCell <= rowLength; rowCell++)
         {
-            auto secondRowMerges = mergeRow(currEdgeIdx, errorAABB, true, rowCell);
-            if (secondRowMerges.size() < rowCell)
+            while (mergedCells < rowCell)
+            {
+                // a rejected first cell is kept, like mergeRow keeps it
+                target.beginTransaction();
+                if (!mergeRow(worker, currEdgeIdx, errorAABB, true, 1).empty())
+                {
+                    target.commit();
+                    mergedCells++;
+                    continue;
+                }
+                if (mergedCells == 0)
+                    target.commit();
+                else
+                    target.rollback();
+                rowStopped = true;
+                break;
+            }
+            if (rowStopped)
             {
                 rowLength = rowCell;
                 break;
             }
 
+            target.beginTransaction();
             for (int j = 0; j < rowIdx; j++)
-                mergeRowWithoutError(rowIdxs[j], rowCell);
+                mergeRowWithoutError(target, rowIdxs[j], rowCell);
 
-            auto colMerges = mergeRow(mergeColIdx, errorAABB, false, rowIdx, rowCell);
-            mesh = readHemeshFile("mesh_saves/save_0.hemesh");
+            auto colMerges = mergeRow(worker, mergeColIdx, errorAABB, false, rowIdx, rowCell);
+            target.rollback();
+            if (stoppedRowMerged)
+            {
+                target.rollback(2);
+                target.beginTransaction();
+                target.beginTransaction();
+                stoppedRowMerged = false;
+                mergedCells = 0;
+            }
             if (colMerges.size() < rowIdx)
             {
                 break;
@@ -258,7 +465,18 @@ void MergePreprocessor::findAllRegions(const std::vector<int> &rowIdxs, int rowL
             auto lastColMerge = colMerges.back();
             regionAttributes.push_back(lastColMerge);
         }
+
+        if (rowStopped)
+        {
+            target.commit();
+            stoppedRowMerged = true;
+        }
+        else
+        {
+            target.rollback();
+        }
     }
+    target.rollback();
 }
 
 void MergePreprocessor::createAdjList()
@@ -271,20 +489,46 @@ void MergePreprocessor::createAdjList()
     std::sort(allTPRs.begin(), allTPRs.end(), [](const TPRNode &a, const TPRNode &b)
               { return a.getMaxPatches() > b.getMaxPatches(); });
 
-    adjList.resize(allTPRs.size());
-    for (int i = 0; i < allTPRs.size(); i++)
+    // Two regions conflict when they share a face. Listing the regions of every face finds all conflicts without
+    // comparing every pair of regions.
+    const int numTPRs = allTPRs.size();
+    std::vector<std::vector<int>> regionFaces(numTPRs);
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < numTPRs; i++)
     {
-        auto &currentTPR = allTPRs[i];
-        for (int j = i + 1; j < allTPRs.size(); j++)
-        {
-            auto &compTPR = allTPRs[j];
-            if (mesh.regionsOverlap({currentTPR.gridPair, currentTPR.maxRegion}, {compTPR.gridPair, compTPR.maxRegion}))
-            {
-                adjList[i].push_back(j);
-                adjList[j].push_back(i);
-            }
-        }
+        auto faces = mesh.getIncidentFacesOfRegion({allTPRs[i].gridPair, allTPRs[i].maxRegion});
+        std::ranges::sort(faces);
+        faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+        regionFaces[i] = std::move(faces);
     }
+
+    // CSR face -> regions, each face's regions in increasing order
+    std::vector<int> faceStart(mesh.getFaces().size() + 1, 0);
+    for (const auto &faces : regionFaces)
+        for (int faceIdx : faces)
+            faceStart[faceIdx + 1]++;
+    for (size_t i = 1; i < faceStart.size(); i++)
+        faceStart[i] += faceStart[i - 1];
+    std::vector<int> faceRegions(faceStart.back());
+    std::vector<int> fill(faceStart.begin(), faceStart.end() - 1);
+    for (int i = 0; i < numTPRs; i++)
+        for (int faceIdx : regionFaces[i])
+            faceRegions[fill[faceIdx]++] = i;
+
+    // sorted neighbours, the order the pairwise comparison produced
+    std::vector<std::vector<int>> neighbourLists(numTPRs);
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < numTPRs; i++)
+    {
+        auto &neighbours = neighbourLists[i];
+        for (int faceIdx : regionFaces[i])
+            for (int k = faceStart[faceIdx]; k < faceStart[faceIdx + 1]; k++)
+                if (faceRegions[k] != i)
+                    neighbours.push_back(faceRegions[k]);
+        std::ranges::sort(neighbours);
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    }
+    adjList = ConflictGraph{neighbourLists};
     for (int i = 0; i < allTPRs.size(); i++)
     {
         allTPRs[i].id = i;
@@ -316,135 +560,180 @@ void MergePreprocessor::computeConflictGraphStats()
 
 void MergePreprocessor::mergeGreedyQuadError()
 {
-    appState.startTime = std::chrono::high_resolution_clock::now();
+    searchThreshold(false);
+}
+
+void MergePreprocessor::mergeGreedyQuadErrorOneStep()
+{
+    // the thresholds of one search share their TPRs and face count, the last one repeats a searched threshold
+    pairScoreCache.clear();
+    searchThreshold(true);
+}
 
+// Searches the error budget of the TPR selection that merges the most faces while the global error stays below the
+// threshold. Every round splits the interval at K thresholds, with K = 1 this is a bisection. Under the CPU backend the
+// K thresholds of a round are evaluated concurrently, each on its own copy of the original mesh. K = 2^m - 1 places
+// them where m bisection steps would look, so a round replaces m steps.
+void MergePreprocessor::searchThreshold(bool oneStep)
+{
     float delta = 0.0001f;
+    appState.startTime = std::chrono::high_resolution_clock::now();
+
     float minThreshold = 0.0f;
     float maxThreshold = appState.mergeSettings.errorThreshold * 2.0f;
-    float bestThreshold;
+    float bestThreshold = minThreshold;
     int bestFaces = std::numeric_limits<int>::max();
     float bestError = std::numeric_limits<float>::max();
 
-    for (int i = 0; i < 10; i++)
+    appState.mesh = appState.originalMesh;
+    float numFaces = getValidCompIndices(mesh.faces).size();
+
+    int stepsPerRound = 1;
+    if (appState.mergeSettings.renderBackend == MergeMetrics::RenderBackend::CPU)
+        while ((2 << stepsPerRound) - 1 <= omp_get_max_threads() && stepsPerRound < THRESHOLD_SEARCH_STEPS)
+            stepsPerRound++;
+    std::vector<std::unique_ptr<MeshWorker>> workers;
+    if (stepsPerRound > 1)
+        for (int i = 0; i < (1 << stepsPerRound) - 1; i++)
+            workers.push_back(std::make_unique<MeshWorker>(mesh));
+
+    for (int i = 0; i < THRESHOLD_SEARCH_STEPS; i += stepsPerRound)
     {
         if (maxThreshold < minThreshold)
             break;
-        float currThreshold = minThreshold + (maxThreshold - minThreshold) / 2.0f;
-        appState.mesh = readHemeshFile("mesh_saves/save_0.hemesh");
-        greedyQuadErrorHeuristic(currThreshold);
-        currIndependentSetIterator = currIndependentSet.begin();
-        // writeHemeshFile("mesh_saves/save_" + std::to_string(++productRegionIteration) + ".hemesh", mesh);
-        mergeIndependentSet();
-        int numFaces = getValidCompIndices(mesh.faces).size();
-        std::cout << "Iteration: " << i
-                  << ", minThreshold: " << minThreshold
-                  << ", maxThreshold: " << maxThreshold
-                  << ", currThreshold: " << currThreshold
-                  << ", numFaces: " << numFaces
-                  << ", mergeError: " << appState.mergeError
-                  << std::endl;
-        if (((numFaces < bestFaces) || (numFaces == bestFaces && appState.mergeError < bestError)) && appState.mergeError < appState.mergeSettings.errorThreshold)
+        // the last round only covers the remaining levels, every thread count searches to the same depth
+        const int numCandidates = (1 << std::min(stepsPerRound, THRESHOLD_SEARCH_STEPS - i)) - 1;
+        std::vector<float> thresholds(numCandidates);
+        for (int k = 0; k < numCandidates; k++)
+            thresholds[k] = minThreshold + (maxThreshold - minThreshold) * (k + 1) / (numCandidates + 1);
+        auto results = workers.empty() ? std::vector<ThresholdResult>{evaluateThreshold(thresholds[0], oneStep, numFaces)}
+                                       : evaluateThresholdsInParallel(workers, thresholds, oneStep, numFaces);
+
+        // the best candidate raises the lower end and the candidate above it lowers the upper end
+        int improved = -1;
+        for (int k = 0; k < numCandidates; k++)
         {
-            bestThreshold = currThreshold;
-            bestFaces = numFaces;
-            bestError = appState.mergeError;
-            minThreshold = currThreshold + delta;
+            auto [numFacesK, mergeError] = results[k];
+            std::cout << "Iteration: " << i
+                      << ", minThreshold: " << minThreshold
+                      << ", maxThreshold: " << maxThreshold
+                      << ", currThreshold: " << thresholds[k]
+                      << ", numFaces: " << numFacesK
+                      << ", mergeError: " << mergeError
+                      << std::endl;
+            if (((numFacesK < bestFaces) || (numFacesK == bestFaces && mergeError < bestError)) && mergeError < appState.mergeSettings.errorThreshold)
+            {
+                bestThreshold = thresholds[k];
+                bestFaces = numFacesK;
+                bestError = mergeError;
+                improved = k;
+            }
+        }
+        if (improved == -1)
+        {
+            maxThreshold = thresholds[0] + delta;
         }
         else
         {
-            maxThreshold = currThreshold + delta;
+            minThreshold = thresholds[improved] + delta;
+            if (improved + 1 < numCandidates)
+                maxThreshold = thresholds[improved + 1] + delta;
         }
     }
 
     std::cout << bestThreshold << std::endl;
 
-    appState.mesh = readHemeshFile("mesh_saves/save_0.hemesh");
-    greedyQuadErrorHeuristic(bestThreshold);
+    currIndependentSet = selectRegions(bestThreshold, oneStep, numFaces).ids;
     currIndependentSetIterator = currIndependentSet.begin();
+    appState.regionsMerged = currIndependentSet.size();
     mergeIndependentSet();
 
     appState.mergeProcess = MergeProcess::Merging;
     printElapsedTime(appState.startTime);
 }
 
-void MergePreprocessor::mergeGreedyQuadErrorOneStep()
+// Merges the selection on the app mesh and scores the global image, the mesh is rolled back afterwards
+MergePreprocessor::ThresholdResult MergePreprocessor::evaluateThreshold(float eps, bool oneStep, float numFaces)
 {
-    float delta = 0.0001f;
-    appState.startTime = std::chrono::high_resolution_clock::now();
-
-    float minThreshold = 0.0f;
-    float maxThreshold = appState.mergeSettings.errorThreshold * 2.0f;
-    float bestThreshold;
-    int bestFaces = std::numeric_limits<int>::max();
-    float bestError = std::numeric_limits<float>::max();
+    mesh.beginTransaction();
+    currIndependentSet = selectRegions(eps, oneStep, numFaces).ids;
+    currIndependentSetIterator = currIndependentSet.begin();
+    appState.regionsMerged = currIndependentSet.size();
+    // writeHemeshFile("mesh_saves/save_" + std::to_string(++productRegionIteration) + ".hemesh", mesh);
+    mergeIndependentSet();
+    int facesAfter = getValidCompIndices(mesh.faces).size();
+    mesh.rollback();
+    return {facesAfter, appState.mergeError};
+}
 
-    for (int i = 0; i < 10; i++)
+std::vector<MergePreprocessor::ThresholdResult> MergePreprocessor::evaluateThresholdsInParallel(std::vector<std::unique_ptr<MeshWorker>> &workers, const std::vector<float> &thresholds, bool oneStep, float numFaces)
+{
+    // the pair scores are cached up front, the workers only read them
+    if (oneStep)
+        for (float eps : thresholds)
+            bestPairScores(eps, appState.quadErrorWeight, numFaces);
+
+    std::vector<ThresholdResult> results(thresholds.size());
+#pragma omp parallel for num_threads(workers.size()) schedule(dynamic, 1)
+    for (int k = 0; k < thresholds.size(); k++)
     {
-        if (maxThreshold < minThreshold)
-            break;
-        float currThreshold = minThreshold + (maxThreshold - minThreshold) / 2.0f;
-        appState.mesh = readHemeshFile("mesh_saves/save_0.hemesh");
-        greedyQuadErrorOneStep(currThreshold);
-        currIndependentSetIterator = currIndependentSet.begin();
-        // writeHemeshFile("mesh_saves/save_" + std::to_string(++productRegionIteration) + ".hemesh", mesh);
-        mergeIndependentSet();
-        int numFaces = getValidCompIndices(mesh.faces).size();
-        std::cout << "Iteration: " << i
-                  << ", minThreshold: " << minThreshold
-                  << ", maxThreshold: " << maxThreshold
-                  << ", currThreshold: " << currThreshold
-                  << ", numFaces: " << numFaces
-                  << ", mergeError: " << appState.mergeError
-                  << std::endl;
-        if (((numFaces < bestFaces) || (numFaces == bestFaces && appState.mergeError < bestError)) && appState.mergeError < appState.mergeSettings.errorThreshold)
+        auto &worker = *workers[k];
+        worker.mesh.beginTransaction();
+        mergeRegions(worker.mesh, selectRegions(thresholds[k], oneStep, numFaces).ids);
+        int facesAfter = getValidCompIndices(worker.mesh.faces).size();
+        if (worker.patchBuffer.update(worker.mesh))
         {
-            bestThreshold = currThreshold;
-            bestFaces = numFaces;
-            bestError = appState.mergeError;
-            minThreshold = currThreshold + delta;
+            merger.metrics.rasterizeGlobalImage(worker.patchBuffer.getData(), worker.image);
+            results[k] = {facesAfter, merger.metrics.evaluateMetric(worker.metricContext, worker.image.view())};
         }
         else
         {
-            maxThreshold = currThreshold + delta;
+            results[k] = {facesAfter, 1.0f};
         }
+        worker.mesh.rollback();
     }
-
-    std::cout << bestThreshold << std::endl;
-
-    appState.mesh = readHemeshFile("mesh_saves/save_0.hemesh");
-    greedyQuadErrorOneStep(bestThreshold);
-    currIndependentSetIterator = currIndependentSet.begin();
-    mergeIndependentSet();
-
-    appState.mergeProcess = MergeProcess::Merging;
-    printElapsedTime(appState.startTime);
+    return results;
 }
 
 void MergePreprocessor::mergeIndependentSet()
 {
-    while (currIndependentSetIterator != currIndependentSet.end())
+    mergeRegions(mesh, {currIndependentSetIterator, currIndependentSet.end()});
+    currIndependentSetIterator = currIndependentSet.end();
+    appState.updateMeshRender();
+    appState.mergeError = merger.metrics.getGlobalError(appState.patchRenderParams.glPatches);
+}
+
+void MergePreprocessor::mergeRegions(GradMesh &target, std::span<const int> tprIdxs) const
+{
+    for (int idx : tprIdxs)
     {
-        auto &tpr = allTPRs[(*currIndependentSetIterator)];
+        auto &tpr = allTPRs[idx];
         // std::cout << " it: " << tpr.gridPair.first << ", " << tpr.gridPair.second << "   " << tpr.maxRegion.first << ", " << tpr.maxRegion.second << std::endl;
-        writeHemeshFile("mesh_saves/lastsave.hemesh", mesh);
-        mergeEdgeRegion({tpr.gridPair, tpr.maxRegion});
-        if (!mesh.generatePatches())
-        {
-            mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
-        }
-        currIndependentSetIterator = std::next(currIndependentSetIterator);
+        target.beginTransaction();
+        mergeEdgeRegion(target, {tpr.gridPair, tpr.maxRegion});
+        if (target.updatePatchCache())
+            target.commit();
+        else
+            target.rollback();
     }
+}
 
-    appState.updateMeshRender();
-    merger.metrics.captureGlobalImage(appState.patchRenderParams.glPatches, CURR_IMG);
-    appState.mergeError = merger.metrics.evaluateMetric(CURR_IMG, ORIG_IMG);
+MergePreprocessor::RegionSelection MergePreprocessor::selectRegions(float eps, bool oneStep, float numFaces)
+{
+    RegionSelection selection;
+    selection.picked.resize(allTPRs.size());
+    if (oneStep)
+        greedyQuadErrorOneStep(eps, numFaces, selection);
+    else
+        greedyQuadErrorHeuristic(eps, numFaces, selection);
+    improveIndependentSet(eps, selection);
+    return selection;
 }
 
-void MergePreprocessor::greedyQuadErrorHeuristic(float eps)
+void MergePreprocessor::greedyQuadErrorHeuristic(float eps, float numFaces, RegionSelection &selection) const
 {
     float w = appState.quadErrorWeight;
     float maxError = eps;
-    float numFaces = getValidCompIndices(mesh.faces).size();
 
     auto cmp = [w, numFaces, maxError](const TPRNode &a, const TPRNode &b)
     {
@@ -460,7 +749,6 @@ void MergePreprocessor::greedyQuadErrorHeuristic(float eps)
         pq.push(tpr);
     }
 
-    currIndependentSet.clear();
     float totalError = 0;
 
     while (!pq.empty() && totalError < eps)
@@ -468,84 +756,139 @@ void MergePreprocessor::greedyQuadErrorHeuristic(float eps)
         auto current = pq.top();
         pq.pop();
 
-        bool canInclude = true;
-        for (int neighbor : adjList[current.id])
-        {
-            if (currIndependentSet.contains(neighbor))
-            {
-                canInclude = false;
-                break;
-            }
-        }
-
-        if (canInclude && (totalError + current.error) < eps)
+        if (canInclude(selection, current.id) && (totalError + current.error) < eps)
         {
-            currIndependentSet.insert(current.id);
+            selection.add(current.id);
             totalError += current.error;
         }
     }
-
-    appState.regionsMerged = currIndependentSet.size();
 }
 
-bool MergePreprocessor::canInclude(int idx)
+bool MergePreprocessor::canInclude(const RegionSelection &selection, int idx) const
 {
     for (int neighbor : adjList[idx])
-        if (currIndependentSet.contains(neighbor))
+        if (selection.picked.test(neighbor))
             return false;
     return true;
 }
 
-void MergePreprocessor::greedyQuadErrorOneStep(float eps)
+void MergePreprocessor::improveIndependentSet(float eps, RegionSelection &selection) const
 {
-    float w = appState.quadErrorWeight;
-    float maxError = eps;
-    float numFaces = getValidCompIndices(mesh.faces).size();
+    std::ranges::sort(selection.ids);
+    int maxIterations = appState.independentSetIterations;
+    float budget = appState.independentSetTime;
+    if ((maxIterations <= 0 && budget <= 0.0f) || allTPRs.empty())
+        return;
 
-    auto cmp = [](const TPRNodePair &a, const TPRNodePair &b)
+    // The weights are the faces a region removes, so the search maximizes what the selection is judged by, within the
+    // error budget the greedy selection fills
+    std::vector<float> weights(allTPRs.size());
+    std::vector<float> costs(allTPRs.size());
+    for (const auto &tpr : allTPRs)
     {
-        return a.score < b.score;
-    };
+        weights[tpr.id] = tpr.getMaxPatches() - 1;
+        costs[tpr.id] = tpr.error;
+    }
 
-    std::priority_queue<TPRNodePair, std::vector<TPRNodePair>, decltype(cmp)> pq(cmp);
-    appState.oneStepQuadErrorProgress = 0.0f;
+    IndependentSetSolver solver{adjList, std::move(weights), std::move(costs), eps};
+    solver.setSolution(selection.ids);
+    solver.improve(budget > 0.0f ? std::chrono::duration<double>(std::chrono::duration<float, std::milli>(budget)) : std::chrono::duration<double>::max(),
+                   maxIterations > 0 ? maxIterations : std::numeric_limits<int>::max());
 
-    for (int i = 0; i < allTPRs.size(); i++)
-    {
-        const auto &tpr1 = allTPRs[i];
-        float scoreA = (w * (tpr1.getMaxPatches() / numFaces) - ((tpr1.error / maxError) * (1.0f - w)));
-        float maxScoreB = scoreA;
+    // the best set starts as the greedy selection, so it never removes fewer faces
+    selection.ids = solver.getBestSet();
+    selection.picked.clear();
+    for (int idx : selection.ids)
+        selection.picked.set(idx);
+}
 
-        for (int j = 0; j < allTPRs.size(); j++)
-        {
-            if (i == j)
-                continue;
-            const auto &tpr2 = allTPRs[j];
+const std::vector<float> &MergePreprocessor::bestPairScores(float eps, float w, float numFaces)
+{
+    for (const auto &cached : pairScoreCache)
+        if (cached.eps == eps && cached.w == w && cached.numFaces == numFaces)
+            return cached.scores;
 
-            bool areAdjacent = false;
+    // A pair score is a term of i plus the score s_j of its partner, so the best non-adjacent partner is the first
+    // one in decreasing s_j order. The exact scores of the partners within rounding distance of it are compared.
+    const int numTPRs = allTPRs.size();
+    float maxError = eps;
+    std::vector<float> partnerScores(numTPRs);
+    float maxMagnitude = 0.0f;
+    for (int j = 0; j < numTPRs; j++)
+    {
+        const auto &tpr = allTPRs[j];
+        float patchTerm = w * (tpr.getMaxPatches() / numFaces);
+        float errorTerm = (1.0f - w) * (tpr.error / maxError);
+        partnerScores[j] = patchTerm - errorTerm;
+        maxMagnitude = std::max(maxMagnitude, std::abs(patchTerm) + std::abs(errorTerm));
+    }
+    const float tolerance = 1e-5f * (2.0f * maxMagnitude + 1.0f);
+    std::vector<int> partners(numTPRs);
+    std::iota(partners.begin(), partners.end(), 0);
+    std::ranges::sort(partners, [&partnerScores](int a, int b)
+                      { return partnerScores[a] > partnerScores[b] || (partnerScores[a] == partnerScores[b] && a < b); });
+
+    std::vector<float> scores(numTPRs);
+#pragma omp parallel
+    {
+        std::vector<int> adjacentTo(numTPRs, -1); // adjacentTo[id] == i marks the neighbours of i
+#pragma omp for schedule(dynamic, 64)
+        for (int i = 0; i < numTPRs; i++)
+        {
+            const auto &tpr1 = allTPRs[i];
             for (int neighbor : adjList[tpr1.id])
+                adjacentTo[neighbor] = i;
+
+            float scoreA = (w * (tpr1.getMaxPatches() / numFaces) - ((tpr1.error / maxError) * (1.0f - w)));
+            float maxScoreB = scoreA;
+            float firstPartnerScore = 0.0f;
+            bool foundPartner = false;
+            for (int j : partners)
             {
-                if (neighbor == tpr2.id)
-                {
-                    areAdjacent = true;
+                const auto &tpr2 = allTPRs[j];
+                if (i == j || adjacentTo[tpr2.id] == i)
+                    continue;
+                if (foundPartner && partnerScores[j] < firstPartnerScore - tolerance)
                     break;
-                }
+                if (!foundPartner)
+                    firstPartnerScore = partnerScores[j];
+                foundPartner = true;
+
+                float normalizedPatchesPair = (tpr1.getMaxPatches() + tpr2.getMaxPatches() - 1) / numFaces;
+                float normalizedErrorPair = (tpr1.error + tpr2.error) / maxError;
+                float score = w * normalizedPatchesPair - (1.0f - w) * normalizedErrorPair;
+                maxScoreB = std::max(maxScoreB, score);
             }
-            if (areAdjacent)
-                continue;
-
-            // float scoreB = (w * (tpr2.getMaxPatches() / numFaces) - ((tpr2.error / maxError) * (1.0f - w)));
-            float normalizedPatchesPair = (tpr1.getMaxPatches() + tpr2.getMaxPatches() - 1) / numFaces;
-            float normalizedErrorPair = (tpr1.error + tpr2.error) / maxError;
-            float score = w * normalizedPatchesPair - (1.0f - w) * normalizedErrorPair;
-            maxScoreB = std::max(maxScoreB, score);
+            scores[i] = maxScoreB;
         }
-        pq.push(TPRNodePair{i, -1, maxScoreB});
     }
 
+    pairScoreCache.push_back({eps, w, numFaces, std::move(scores)});
+    return pairScoreCache.back().scores;
+}
+
+// The pair scores of eps have to be cached before this runs in parallel
+void MergePreprocessor::greedyQuadErrorOneStep(float eps, float numFaces, RegionSelection &selection)
+{
+    float w = appState.quadErrorWeight;
+    // only the main thread reports progress
+    bool reportProgress = !omp_in_parallel();
+
+    auto cmp = [](const TPRNodePair &a, const TPRNodePair &b)
+    {
+        return a.score < b.score;
+    };
+
+    std::priority_queue<TPRNodePair, std::vector<TPRNodePair>, decltype(cmp)> pq(cmp);
+    if (reportProgress)
+        appState.oneStepQuadErrorProgress = 0.0f;
+
+    const auto &scores = bestPairScores(eps, w, numFaces);
+    for (int i = 0; i < allTPRs.size(); i++)
+        pq.push(TPRNodePair{i, -1, scores[i]});
+
     int pqSize = pq.size();
 
-    currIndependentSet.clear();
     float totalError = 0;
     int processedNodes = 0;
 
@@ -557,9 +900,9 @@ void MergePreprocessor::greedyQuadErrorOneStep(float eps)
         if (current.j == -1)
         {
             float nodeError = allTPRs[current.i].error;
-            if (canInclude(current.i) && (totalError + nodeError) < eps)
+            if (canInclude(selection, current.i) && (totalError + nodeError) < eps)
             {
-                currIndependentSet.insert(current.i);
+                selection.add(current.i);
                 totalError += nodeError;
             }
         }
@@ -567,37 +910,36 @@ void MergePreprocessor::greedyQuadErrorOneStep(float eps)
         {
             float nodeError1 = allTPRs[current.i].error;
             float nodeError2 = allTPRs[current.j].error;
-            if (canInclude(current.i) && canInclude(current.j) && (totalError + nodeError1 + nodeError2) < eps)
+            if (canInclude(selection, current.i) && canInclude(selection, current.j) && (totalError + nodeError1 + nodeError2) < eps)
             {
-                currIndependentSet.insert(current.i);
-                currIndependentSet.insert(current.j);
+                selection.add(current.i);
+                selection.add(current.j);
                 totalError += nodeError1 + nodeError2;
             }
         }
         processedNodes++;
-        if (processedNodes % 10000 == 0)
+        if (reportProgress && processedNodes % 10000 == 0)
             appState.oneStepQuadErrorProgress = static_cast<int>(processedNodes) / pqSize;
     }
 
-    appState.regionsMerged = currIndependentSet.size();
-    appState.oneStepQuadErrorProgress = -1.0f;
+    if (reportProgress)
+        appState.oneStepQuadErrorProgress = -1.0f;
 }
 
 int MergePreprocessor::binarySearch(const std::vector<int> &arr, int left, float eps)
 {
     int right = arr.size() - 1;
     int bestMerge = -1;
-    writeHemeshFile("mesh_saves/lastsave.hemesh", mesh);
 
     while (left <= right)
     {
-        mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
         int mid = left + (right - left) / 2;
         const auto &tpr = allTPRs[arr[mid]];
-        mergeEdgeRegion({tpr.gridPair, tpr.maxRegion});
+        mesh.beginTransaction();
+        mergeEdgeRegion(mesh, {tpr.gridPair, tpr.maxRegion});
         appState.updateMeshRender();
-        merger.metrics.captureGlobalImage(appState.patchRenderParams.glPatches, CURR_IMG);
-        float mergeError = merger.metrics.evaluateMetric(CURR_IMG, ORIG_IMG);
+        float mergeError = merger.metrics.getGlobalError(appState.patchRenderParams.glPatches);
+        mesh.rollback();
 
         if (mergeError < eps)
         {
@@ -611,7 +953,6 @@ int MergePreprocessor::binarySearch(const std::vector<int> &arr, int left, float
             left = mid + 1; // Search in the right half
         }
     }
-    mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
 
     return bestMerge;
 }
@@ -633,20 +974,20 @@ void MergePreprocessor::mergeEdgeRegionWithError(const Region &region)
             if (!mesh.validMergeEdge(currEdge))
                 break;
 
-            writeHemeshFile("mesh_saves/lastsave.hemesh", mesh);
+            mesh.beginTransaction();
             AABB aabb;
             float mergeError = merger.attemptMerge(currEdgeIdx, aabb);
             if (mergeError > appState.mergeSettings.errorThreshold)
             {
-                mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
+                mesh.rollback();
                 int twinIdx = mesh.edges[currEdgeIdx].twinIdx;
                 if (twinIdx != -1)
                     currEdgeIdx = mesh.getFaceEdgeIdxs(twinIdx)[2];
             }
-        }
-        if (!mesh.generatePatches())
-        {
-            mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
+            else
+            {
+                mesh.commit();
+            }
         }
         return;
     }
@@ -667,17 +1008,21 @@ void MergePreprocessor::mergeEdgeRegionWithError(const Region &region)
             if (!mesh.validMergeEdge(currEdge))
                 break;
 
-            writeHemeshFile("mesh_saves/lastsave.hemesh", mesh);
+            mesh.beginTransaction();
             AABB aabb;
             float mergeError = merger.attemptMerge(currEdgeIdx, aabb);
             verticalEdgeIdxs.insert(mesh.edges[currEdgeIdx].prevIdx);
             if (mergeError > appState.mergeSettings.errorThreshold)
             {
-                mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
+                mesh.rollback();
                 int twinIdx = mesh.edges[currEdgeIdx].twinIdx;
                 if (twinIdx != -1)
                     currEdgeIdx = mesh.getFaceEdgeIdxs(twinIdx)[2];
             }
+            else
+            {
+                mesh.commit();
+            }
         }
     }
     if (maxRegion.second == 0)
@@ -691,21 +1036,23 @@ void MergePreprocessor::mergeEdgeRegionWithError(const Region &region)
             if (!mesh.validMergeEdge(currEdge))
                 break;
 
-            writeHemeshFile("mesh_saves/lastsave.hemesh", mesh);
+            mesh.beginTransaction();
             AABB aabb;
             float mergeError = merger.attemptMerge(verticalEdgeIdx, aabb);
             if (mergeError > appState.mergeSettings.errorThreshold)
             {
-                mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
+                mesh.rollback();
                 break;
             }
+            mesh.commit();
         }
     }
 }
 
-void MergePreprocessor::mergeEdgeRegion(const Region &region)
+// Commits the merged region, or rolls it back if the patches cannot be generated
+void MergePreprocessor::mergeEdgeRegion(GradMesh &target, const Region &region) const
 {
-    writeHemeshFile("mesh_saves/lastsave.hemesh", mesh);
+    target.beginTransaction();
     auto [rowIdx, colIdx] = region[0];
     auto maxRegion = region[1];
 
@@ -713,16 +1060,16 @@ void MergePreprocessor::mergeEdgeRegion(const Region &region)
     int currRowIdx = rowIdx;
     if (maxRegion.first == 0)
     {
-        mergeRowWithoutError(colIdx, maxRegion.second);
-        if (!mesh.generatePatches())
-        {
-            mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
-        }
+        mergeRowWithoutError(target, colIdx, maxRegion.second);
+        if (target.updatePatchCache())
+            target.commit();
+        else
+            target.rollback();
         return;
     }
     for (int i = 0; i < maxRegion.second; i++)
     {
-        currRowIdx = mesh.getNextRowIdx(currRowIdx);
+        currRowIdx = target.getNextRowIdx(currRowIdx);
         if (currRowIdx == -1)
             break;
         rowIdxs.push_back(currRowIdx);
@@ -732,14 +1079,15 @@ void MergePreprocessor::mergeEdgeRegion(const Region &region)
     {
         // if (!mesh.edges[rowIdxs[i]].isValid())
         // std::cout << "invalid" << std::endl;
-        mergeRowWithoutError(rowIdxs[i], maxRegion.first);
-        if (!mesh.generatePatches())
+        mergeRowWithoutError(target, rowIdxs[i], maxRegion.first);
+        if (!target.updatePatchCache())
         {
-            mesh = readHemeshFile("mesh_saves/lastsave.hemesh");
+            target.rollback();
             return;
         }
     }
-    mergeRowWithoutError(mesh.edges[rowIdxs[0]].nextIdx, maxRegion.second);
+    mergeRowWithoutError(target, target.edges[rowIdxs[0]].nextIdx, maxRegion.second);
+    target.commit();
     // if (!mesh.edges[mesh.edges[rowIdxs[0]].nextIdx].isValid())
     // std::cout << "invalid" << std::endl;
 }
@@ -2,6 +2,7 @@
 
 #include "renderer.hpp"
 #include "gms_app.hpp"
+#include "patch_vertex_buffer.hpp"
 
 GmsRenderer::GmsRenderer(GmsWindow &window, GmsAppState &appState) : window{window}, appState{appState}
 {
@@ -88,7 +89,7 @@ void setLineColor(GLuint shaderId, const glm::vec3 &color)
     glUniform3fv(lineColorLocation, 1, glm::value_ptr(color));
 }
 
-void setVertexData(std::vector<GLfloat> vertexData)
+void setVertexData(const std::vector<GLfloat> &vertexData)
 {
     glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(GLfloat), vertexData.data(), GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, coords));
@@ -126,4 +127,18 @@ void drawPrimitive(const std::vector<GLfloat> &glData, int shaderId, const AABB
     setProjectionMatrixAABB(shaderId, aabb);
     glPatchParameteri(GL_PATCH_VERTICES, vertsPerPrimitive);
     glDrawArrays(GL_PATCHES, 0, glData.size() / 5);
-}
\ No newline at end of file
+}
+
+// Draws from the patch buffer's own VBO, the previously bound buffer is restored so the next setVertexData
+// does not overwrite the persistent patch slots
+void drawPrimitive(PatchVertexBuffer &patchBuffer, int shaderId, const AABB &aabb)
+{
+    GLint previousBuffer = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previousBuffer);
+    patchBuffer.bind();
+    glUseProgram(shaderId);
+    setProjectionMatrixAABB(shaderId, aabb);
+    glPatchParameteri(GL_PATCH_VERTICES, VERTS_PER_PATCH);
+    glDrawArrays(GL_PATCHES, 0, patchBuffer.numVertices());
+    glBindBuffer(GL_ARRAY_BUFFER, previousBuffer);
+}
@@ -0,0 +1,248 @@
+#include "candidate_merges.hpp"
+#include "fileio.hpp"
+#include "merge_metrics.hpp"
+#include "patch_merger.hpp"
+#include "patch_rasterizer.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+// Headless checks run by CTest, see CMakeLists.txt. Each check is a subcommand that prints what it compared and returns
+// 0 when it passes.
+
+namespace
+{
+    // Resolution of the longer side of the reference images in tests/data
+    inline constexpr int REFERENCE_RES{256};
+    // GL and the software rasterizer interpolate colors with different rounding, and a pixel centre exactly on a shared
+    // patch edge may be covered by either patch
+    inline constexpr int RASTER_CHANNEL_TOLERANCE{1};
+    inline constexpr double RASTER_MAX_OUTLIER_FRACTION{0.001};
+    inline constexpr int CANDIDATE_STEPS{300};
+
+    // Binary PPM (P6) with 8-bit RGB, rows bottom-up as read back with glReadPixels
+    bool readPPM(const std::string &path, Image &image)
+    {
+        std::ifstream inf{path, std::ios::binary};
+        std::string magic;
+        int width = 0, height = 0, maxValue = 0;
+        if (!(inf >> magic >> width >> height >> maxValue) || magic != "P6" || maxValue != 255 || width <= 0 || height <= 0)
+            return false;
+        inf.get(); // the single whitespace before the pixels
+        image.resize(width, height, 3);
+        return static_cast<bool>(inf.read(reinterpret_cast<char *>(image.pixels.data()), image.pixels.size()));
+    }
+
+    // Renders the mesh with the software rasterizer at the global capture settings (padded mesh AABB) and compares it
+    // with an image of the same view rendered through the GL patch shaders
+    int testRasterizer(int argc, char **argv)
+    {
+        if (argc != 3)
+        {
+            std::cerr << "usage: gms-tests rasterizer <mesh.hemesh> <reference.ppm>" << std::endl;
+            return 1;
+        }
+
+        Image reference;
+        if (!readPPM(argv[2], reference))
+        {
+            std::cerr << "Could not read " << argv[2] << std::endl;
+            return 1;
+        }
+        GradMesh mesh = readMeshFile(argv[1]);
+        auto patches = mesh.generatePatches();
+        if (!patches)
+        {
+            std::cerr << "Could not generate the patches of " << argv[1] << std::endl;
+            return 1;
+        }
+
+        AABB aabb = mesh.getMeshAABB();
+        aabb.addPadding(AABB_PADDING);
+        aabb.ensureSize(MIN_AABB_SIZE);
+        auto [width, height] = aabb.getRes(REFERENCE_RES);
+        Image image;
+        rasterizePatches(getAllPatchGLData(patches.value(), &Patch::getControlMatrix), aabb, width, height, image);
+
+        ImageDifference diff = compareImages(image.view(), reference.view(), RASTER_CHANNEL_TOLERANCE);
+        if (diff.differingPixels < 0)
+        {
+            std::cerr << "Rendered " << width << "x" << height << ", the reference is " << reference.width << "x" << reference.height << std::endl;
+            return 1;
+        }
+        const int maxOutliers = static_cast<int>(RASTER_MAX_OUTLIER_FRACTION * width * height);
+        std::cout << argv[1] << ": " << diff.differingPixels << " of " << width * height << " pixels differ by more than "
+                  << RASTER_CHANNEL_TOLERANCE << " (at most " << maxOutliers << " allowed), max channel difference "
+                  << diff.maxChannelDifference << std::endl;
+        return diff.differingPixels <= maxOutliers ? 0 : 1;
+    }
+
+    // Writes the mesh as .hemeshb, reads it back and requires every point, handle, face and edge to be identical
+    int testHemeshRoundTrip(int argc, char **argv)
+    {
+        if (argc != 2)
+        {
+            std::cerr << "usage: gms-tests hemesh-roundtrip <mesh.hemesh>" << std::endl;
+            return 1;
+        }
+
+        GradMesh mesh = readMeshFile(argv[1]);
+        std::filesystem::path binaryPath = std::filesystem::temp_directory_path() /
+                                           (std::filesystem::path{argv[1]}.stem().string() + ".gms-tests" + std::string{HEMESHB_EXTENSION});
+        writeMeshFile(binaryPath.string(), mesh);
+        GradMesh written = readMeshFile(binaryPath.string());
+        std::filesystem::remove(binaryPath);
+
+        bool same = written.sameAs(mesh);
+        std::cout << argv[1] << ": " << mesh.getPoints().size() << " points, " << mesh.getHandles().size() << " handles, "
+                  << mesh.getFaces().size() << " faces, " << mesh.getEdges().size() << " edges"
+                  << (same ? ", identical after the binary round trip" : ", CHANGED BY THE BINARY ROUND TRIP") << std::endl;
+        return same ? 0 : 1;
+    }
+
+    // The in-place from_chars reader has to build the same mesh as the previous stringstream based one
+    int testHemeshReaders(int argc, char **argv)
+    {
+        if (argc != 2)
+        {
+            std::cerr << "usage: gms-tests hemesh-readers <mesh.hemesh>" << std::endl;
+            return 1;
+        }
+
+        bool same = readHemeshFile(argv[1]).sameAs(readHemeshFileStream(argv[1]));
+        std::cout << argv[1] << (same ? ": both text readers build the same mesh" : ": THE TEXT READERS DIFFER") << std::endl;
+        return same ? 0 : 1;
+    }
+
+    using CandidateKey = std::tuple<int, int, int, int, int, int>;
+
+    std::set<CandidateKey> candidateKeys(const CandidateMerges &candidates)
+    {
+        std::set<CandidateKey> keys;
+        for (const auto &dhe : candidates)
+            keys.insert({dhe.halfEdgeIdx1, dhe.halfEdgeIdx2, dhe.curveId1.patchId, dhe.curveId1.curveId, dhe.curveId2.patchId,
+                         dhe.curveId2.curveId});
+        return keys;
+    }
+
+    // Runs a seeded sequence of merges that are committed or rolled back, with undos and redos in between, and requires
+    // the incrementally updated candidates to hold the same entries as a rebuild after every step
+    int testCandidateMerges(int argc, char **argv)
+    {
+        if (argc != 2 && argc != 3)
+        {
+            std::cerr << "usage: gms-tests candidates <mesh.hemesh> [seed]" << std::endl;
+            return 1;
+        }
+
+        std::mt19937 gen(argc == 3 ? std::atoi(argv[2]) : 1);
+        GradMesh mesh = readMeshFile(argv[1]);
+        mesh.findULPoints();
+        CandidateMerges candidates;
+        candidates.rebuild(mesh);
+
+        int step = 0, commits = 0, rollbacks = 0, undos = 0, redos = 0;
+        for (; step < CANDIDATE_STEPS && !candidates.empty(); step++)
+        {
+            int action = std::uniform_int_distribution<int>(0, 9)(gen);
+            if (action == 0 && mesh.canUndo())
+            {
+                mesh.undo();
+                undos++;
+            }
+            else if (action == 1 && mesh.canRedo())
+            {
+                mesh.redo();
+                redos++;
+            }
+            else
+            {
+                int slot = std::uniform_int_distribution<int>(0, candidates.size() - 1)(gen);
+                mesh.beginTransaction();
+                PatchMerger{mesh}.merge(candidates[slot].getHalfEdgeIdx());
+                // a merge without valid patches is never kept by the merge strategies either
+                if (action < 6 && mesh.updatePatchCache())
+                {
+                    mesh.commit(true);
+                    commits++;
+                }
+                else
+                {
+                    mesh.rollback();
+                    rollbacks++;
+                }
+            }
+
+            candidates.update(mesh);
+            candidates.resolveCurveIds(mesh);
+            CandidateMerges rebuilt;
+            rebuilt.rebuild(mesh);
+            if (candidateKeys(candidates) != candidateKeys(rebuilt))
+            {
+                std::cerr << argv[1] << ": step " << step << " has " << candidates.size() << " candidates, a rebuild "
+                          << rebuilt.size() << " or different ones" << std::endl;
+                return 1;
+            }
+            for (size_t i = 0; i < candidates.size(); i++)
+            {
+                if (candidates.find(candidates[i].halfEdgeIdx1) != static_cast<int>(i) ||
+                    candidates.find(candidates[i].halfEdgeIdx2) != static_cast<int>(i))
+                {
+                    std::cerr << argv[1] << ": step " << step << " does not find candidate " << i << " by its half-edges" << std::endl;
+                    return 1;
+                }
+            }
+        }
+
+        std::cout << argv[1] << ": " << step << " steps (" << commits << " commits, " << rollbacks << " rollbacks, " << undos
+                  << " undos, " << redos << " redos), " << candidates.size() << " candidates match a rebuild" << std::endl;
+        return 0;
+    }
+
+    struct TestCommand
+    {
+        std::string_view name;
+        int (*run)(int argc, char **argv);
+    };
+
+    inline constexpr TestCommand TEST_COMMANDS[] = {
+        {"rasterizer", testRasterizer},
+        {"hemesh-roundtrip", testHemeshRoundTrip},
+        {"hemesh-readers", testHemeshReaders},
+        {"candidates", testCandidateMerges},
+    };
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        for (const auto &command : TEST_COMMANDS)
+        {
+            if (command.name != argv[1])
+                continue;
+            try
+            {
+                return command.run(argc - 1, argv + 1);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << command.name << " failed: " << e.what() << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    std::cerr << "usage: gms-tests <check> <args>..., checks:";
+    for (const auto &command : TEST_COMMANDS)
+        std::cerr << " " << command.name;
+    std::cerr << std::endl;
+    return 1;
+}